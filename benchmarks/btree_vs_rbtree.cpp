@@ -0,0 +1,72 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Memory per key and lookup latency of btree_ordered_set against the red-black ordered_set, on random 64-bit keys,
+// and of ordered_set with each layout and size width on random 64-bit and 32-bit keys.
+// Usage: btree_vs_rbtree [size = 10000000] [queries = 1000000]
+//
+
+#include "../ordered_set.cpp"
+#include "../btree_ordered_set.cpp"
+
+using Clock = chrono::steady_clock;
+
+struct compact : tree_policy { using layout = compact_layout; };
+
+// Sizes default to 64 bits with pointers and 32 with indices, these take the other width.
+struct narrow : tree_policy { using size_type = uint32_t; };
+
+struct wide_compact : compact { using size_type = uint64_t; };
+
+// Returns the nanoseconds per call of f over the queries, f folding each into a checksum so that it can't be optimized out.
+template<typename F>
+double time_per_call(const vector<long long> &queries, F f) {
+    long long checksum = 0;
+    auto start = Clock::now();
+    for (long long q: queries) checksum += f(q);
+    double ns = chrono::duration<double, nano>(Clock::now() - start).count() / double(queries.size());
+    if (checksum == 42) puts("");
+    return ns;
+}
+
+template<typename Set, typename K = long long>
+void run(const char *name, const vector<long long> &keys, const vector<long long> &queries) {
+    auto start = Clock::now();
+    Set set;
+    for (long long key: keys) set.insert(K(key));
+    double insert_ns = chrono::duration<double, nano>(Clock::now() - start).count() / double(keys.size());
+    
+    long long n = (long long) set.size();
+    double find_ns = time_per_call(queries, [&](long long q) { return set.find(K(q)) != set.end(); });
+    double rank_ns = time_per_call(queries, [&](long long q) { return (long long) set.order_of_key(K(q)); });
+    double lower_ns = time_per_call(queries, [&](long long q) { auto it = set.lower_bound(K(q)); return it != set.end() ? (long long) *it : 0; });
+    double select_ns = time_per_call(queries, [&](long long q) { return (long long) *set.find_by_order(q % n); });
+    double bytes = double(set.memory_usage()) / n;
+    printf("%-22s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, bytes, insert_ns, find_ns, rank_ns, lower_ns, select_ns);
+}
+
+int main(int argc, char **argv) {
+    int size = argc > 1 ? atoi(argv[1]) : 10000000;
+    int query_count = argc > 2 ? atoi(argv[2]) : 1000000;
+    
+    mt19937_64 rng(42);
+    vector<long long> keys(size), queries(query_count);
+    for (long long &key: keys) key = (long long) (rng() >> 1);
+    for (int i = 0; i < query_count; i++) queries[i] = i % 2 ? keys[rng() % size] : (long long) (rng() >> 1);
+    
+    printf("%-22s %10s %10s %10s %10s %10s %10s\n", "ns per op", "bytes/key", "insert", "find", "order_of", "lower_bnd", "by_order");
+    run<ordered_set<long long>>("ordered_set", keys, queries);
+    run<ordered_set<long long, less<long long>, allocator<long long>, narrow>>("ordered_set 32-bit", keys, queries);
+    run<ordered_set<long long, less<long long>, allocator<long long>, compact>>("ordered_set compact", keys, queries);
+    run<ordered_set<long long, less<long long>, allocator<long long>, wide_compact>>("ordered_set compact 64", keys, queries);
+    run<btree_ordered_set<long long, 16>>("btree_ordered_set 16", keys, queries);
+    run<btree_ordered_set<long long, 32>>("btree_ordered_set 32", keys, queries);
+    run<btree_ordered_set<long long, 64>>("btree_ordered_set 64", keys, queries);
+    
+    // Keys cut to 32 bits, where the size width decides whether a pointer_layout node is 32 or 40 bytes.
+    puts("32-bit keys");
+    run<ordered_set<int>, int>("ordered_set", keys, queries);
+    run<ordered_set<int, less<int>, allocator<int>, narrow>, int>("ordered_set 32-bit", keys, queries);
+    run<ordered_set<int, less<int>, allocator<int>, compact>, int>("ordered_set compact", keys, queries);
+    run<ordered_set<int, less<int>, allocator<int>, wide_compact>, int>("ordered_set compact 64", keys, queries);
+}
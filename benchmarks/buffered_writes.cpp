@@ -0,0 +1,68 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Bursts of random 64-bit inserts into buffered_ordered_set, against inserting them one by one into an ordered_set and against just sorting them,
+// into an empty set and into one already holding size keys, then with an order_of_key after every 1000 inserts. Prints nanoseconds per key, the fastest of repeat runs.
+// Usage: buffered_writes [size = 1000000] [repeat = 3]
+//
+
+#include "../buffered_ordered_set.cpp"
+
+using Clock = chrono::steady_clock;
+
+// Returns the nanoseconds f took, divided by count.
+template<typename F>
+double time_per_key(size_t count, F f) {
+    auto start = Clock::now();
+    f();
+    return chrono::duration<double, nano>(Clock::now() - start).count() / double(count);
+}
+
+int main(int argc, char **argv) {
+    int size = argc > 1 ? atoi(argv[1]) : 1000000;
+    int repeat = argc > 2 ? atoi(argv[2]) : 3;
+    constexpr int READ_EVERY = 1000;
+    
+    mt19937_64 rng(42);
+    vector<long long> initial(size), burst(size);
+    for (long long &key: initial) key = (long long) (rng() >> 1);
+    for (long long &key: burst) key = (long long) (rng() >> 1);
+    
+    // ns[into][container]: into an empty set, into a full one, and with reads in between; sorted, buffered or one by one.
+    double ns[3][3];
+    for (auto &row: ns) fill(begin(row), end(row), 1e18);
+    long long checksum = 0;
+    for (int r = 0; r < repeat; r++) {
+        for (int into = 0; into < 3; into++) {
+            vector<long long> keys = burst;
+            ns[into][0] = min(ns[into][0], time_per_key(size, [&] { sort(keys.begin(), keys.end()); }));
+            
+            buffered_ordered_set<long long> buffered;
+            if (into) {
+                for (long long key: initial) buffered.insert(key);
+                buffered.flush();
+            }
+            ns[into][1] = min(ns[into][1], time_per_key(size, [&] {
+                for (int i = 0; i < size; i++) {
+                    buffered.insert(burst[i]);
+                    if (into == 2 && i % READ_EVERY == 0) checksum += buffered.order_of_key(burst[i]);
+                }
+                buffered.flush();
+            }));
+            
+            ordered_set<long long> set;
+            if (into) set.insert(initial.begin(), initial.end());
+            ns[into][2] = min(ns[into][2], time_per_key(size, [&] {
+                for (int i = 0; i < size; i++) {
+                    set.insert(burst[i]);
+                    if (into == 2 && i % READ_EVERY == 0) checksum += set.order_of_key(burst[i]);
+                }
+            }));
+            checksum += buffered.size() - set.size();
+        }
+    }
+    if (checksum == 42) puts("");
+    printf("%-44s %10s %10s %10s\n", "", "sort", "buffered", "one by one");
+    const char *names[] = {"burst into an empty set", "burst into a set of size keys", "... with an order_of_key every 1000 keys"};
+    for (int into = 0; into < 3; into++) printf("%-44s %10.1f %10.1f %10.1f\n", names[into], ns[into][0], ns[into][1], ns[into][2]);
+}
@@ -0,0 +1,82 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Read throughput of concurrent_ordered_set against an ordered_set behind a shared_mutex,
+// with one writer inserting and erasing random keys the whole time.
+// Usage: concurrent_readers [max_readers = hardware threads] [size = 1000000] [seconds per run = 1]
+//
+
+#include "../concurrent_ordered_set.cpp"
+
+struct locked_ordered_set {
+    ordered_set<int> set;
+    mutable shared_mutex lock;
+    
+    int order_of_key(int key) const {
+        shared_lock guard(lock);
+        return set.order_of_key(key);
+    }
+    
+    bool insert(int key) {
+        unique_lock guard(lock);
+        return set.insert(key).second;
+    }
+    
+    bool erase(int key) {
+        unique_lock guard(lock);
+        return set.erase(key);
+    }
+};
+
+// Returns the total number of order_of_key calls per second the readers managed.
+template<typename Set>
+double run(Set &set, int readers, int size, double seconds) {
+    atomic<bool> stop{false};
+    atomic<long long> queries{0};
+    thread writer([&] {
+        mt19937 rng(0);
+        while (!stop.load()) {
+            int key = int(rng() % (2 * size));
+            if (!set.erase(key)) set.insert(key);
+        }
+    });
+    vector<thread> threads;
+    for (int i = 0; i < readers; i++) {
+        threads.emplace_back([&, i] {
+            mt19937 rng(i + 1);
+            long long count = 0, checksum = 0;
+            while (!stop.load()) {
+                for (int j = 0; j < 256; j++) checksum += set.order_of_key(int(rng() % (2 * size)));
+                count += 256;
+            }
+            queries += count + (checksum == -1);
+        });
+    }
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    stop = true;
+    writer.join();
+    for (thread &t: threads) t.join();
+    return double(queries.load()) / seconds;
+}
+
+int main(int argc, char **argv) {
+    int max_readers = argc > 1 ? atoi(argv[1]) : int(max(1u, thread::hardware_concurrency()));
+    int size = argc > 2 ? atoi(argv[2]) : 1000000;
+    double seconds = argc > 3 ? atof(argv[3]) : 1;
+    
+    concurrent_ordered_set<int> concurrent;
+    locked_ordered_set locked;
+    mt19937 rng(42);
+    for (int i = 0; i < size; i++) {
+        int key = int(rng() % (2 * size));
+        concurrent.insert(key);
+        locked.insert(key);
+    }
+    
+    printf("%8s %16s %16s\n", "readers", "concurrent q/s", "shared_mutex q/s");
+    for (int readers = 1; readers <= max_readers; readers *= 2) {
+        double a = run(concurrent, readers, size, seconds);
+        double b = run(locked, readers, size, seconds);
+        printf("%8d %16.0f %16.0f\n", readers, a, b);
+    }
+}
@@ -0,0 +1,262 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// ordered_set against std::set and __gnu_pbds::tree with tree_order_statistics_node_update, on 64-bit and string keys,
+// for sizes 10^3, 10^4, ... up to --max-size, with sequential, random and Zipfian access.
+// Prints one row per (container, key, size, pattern, operation) with nanoseconds per operation, as CSV or JSON, for tracking over time.
+// Operations a container lacks (order statistics in std::set, iterator arithmetic and for_each scans in both baselines) are left out rather than emulated in O(n).
+// With --repeat=r every measurement is taken r times and the fastest is kept, which filters out most noise on a busy machine.
+// Usage: ordered_set_benchmark [--format=csv|json] [--max-size=1000000] [--queries=1000000] [--repeat=1] [--seed=42]
+// A 10^8 run needs tens of GB of memory, most of it for std::set and the string keys.
+//
+
+#include "../ordered_set.cpp"
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+
+using Clock = chrono::steady_clock;
+
+template<typename K>
+using pbds_tree = __gnu_pbds::tree<K, __gnu_pbds::null_type, less<K>, __gnu_pbds::rb_tree_tag, __gnu_pbds::tree_order_statistics_node_update>;
+
+enum class Pattern {
+    SEQUENTIAL, RANDOM, ZIPF
+};
+
+const char *pattern_name(Pattern pattern) {
+    switch (pattern) {
+        case Pattern::SEQUENTIAL: return "sequential";
+        case Pattern::RANDOM: return "random";
+        default: return "zipf";
+    }
+}
+
+// Samples 1..n with probability proportional to k^-s in O(1) time and memory, by rejection-inversion (Hormann and Derflinger), so that 10^8 ranks need no table.
+class zipf_distribution {
+public:
+    zipf_distribution(long long n, double s) : n_(n), s_(s) {
+        h_integral_x1_ = h_integral(1.5) - 1;
+        h_integral_n_ = h_integral(double(n) + 0.5);
+        threshold_ = 2 - h_integral_inverse(h_integral(2.5) - h(2));
+    }
+    
+    template<typename Rng>
+    long long operator()(Rng &rng) {
+        uniform_real_distribution<double> uniform(0, 1);
+        while (true) {
+            double u = h_integral_n_ + uniform(rng) * (h_integral_x1_ - h_integral_n_);
+            double x = h_integral_inverse(u);
+            long long k = clamp((long long) (x + 0.5), 1LL, n_);
+            if (double(k) - x <= threshold_ || u >= h_integral(double(k) + 0.5) - h(double(k))) return k;
+        }
+    }
+
+private:
+    long long n_;
+    double s_, h_integral_x1_, h_integral_n_, threshold_;
+    
+    // log1p(x) / x and expm1(x) / x, both 1 at 0.
+    static double log1p_ratio(double x) { return abs(x) > 1e-8 ? log1p(x) / x : 1 - x / 2; }
+    
+    static double expm1_ratio(double x) { return abs(x) > 1e-8 ? expm1(x) / x : 1 + x / 2; }
+    
+    double h(double x) const { return exp(-s_ * log(x)); }
+    
+    double h_integral(double x) const { return expm1_ratio((1 - s_) * log(x)) * log(x); }
+    
+    double h_integral_inverse(double x) const {
+        double t = max(x * (1 - s_), -1.0);
+        return exp(log1p_ratio(t) * x);
+    }
+};
+
+// Keys are generated in increasing order, so the i-th key is also the i-th smallest.
+template<typename K>
+K make_key(long long i, mt19937_64 &rng);
+
+template<>
+long long make_key<long long>(long long i, mt19937_64 &rng) { return i * 16 + (long long) (rng() % 16); }
+
+// Zero-padded so that string order matches number order.
+template<>
+string make_key<string>(long long i, mt19937_64 &rng) {
+    char buffer[24];
+    snprintf(buffer, sizeof buffer, "%016lld", i * 16 + (long long) (rng() % 16));
+    return buffer;
+}
+
+long long digest(long long key) { return key; }
+
+long long digest(const string &key) { return (long long) key.size() + key.back(); }
+
+// Returns count indices into [0, n) in the given pattern: increasing (wrapping around), uniform, or Zipfian with s = 0.99.
+// Zipfian ranks are scattered over [0, n) by a multiplier coprime with n, so hot keys aren't neighbors.
+vector<int> make_indices(Pattern pattern, int n, int count, mt19937_64 &rng) {
+    vector<int> indices(count);
+    if (pattern == Pattern::SEQUENTIAL) {
+        for (int i = 0; i < count; i++) indices[i] = i % n;
+    } else if (pattern == Pattern::RANDOM) {
+        for (int &index: indices) index = int(rng() % n);
+    } else {
+        zipf_distribution zipf(n, 0.99);
+        long long multiplier = 2654435761LL % n;
+        while (gcd(multiplier, (long long) n) != 1) multiplier++;
+        for (int &index: indices) index = int((zipf(rng) - 1) * multiplier % n);
+    }
+    return indices;
+}
+
+struct Result {
+    string container, key;
+    int size;
+    Pattern pattern;
+    string operation;
+    double ns;
+};
+
+vector<Result> results;
+
+// Adds a measurement, or keeps the faster one if it was taken before.
+void record(const Result &result) {
+    for (Result &r: results) {
+        if (r.container == result.container && r.key == result.key && r.size == result.size && r.pattern == result.pattern && r.operation == result.operation) {
+            r.ns = min(r.ns, result.ns);
+            return;
+        }
+    }
+    results.push_back(result);
+}
+
+// Runs f(i) for every i in [0, count) and returns the nanoseconds per call, f folding each result into a checksum so that it can't be optimized out.
+template<typename F>
+double time_per_call(size_t count, F f) {
+    long long checksum = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; i++) checksum += f(i);
+    double ns = chrono::duration<double, nano>(Clock::now() - start).count() / double(count);
+    if (checksum == 42) puts("");
+    return ns;
+}
+
+template<typename Set, typename K>
+void fill(Set &set, const vector<K> &keys) { for (const K &key: keys) set.insert(key); }
+
+template<typename Set, typename K>
+void run(const char *container, const char *key_name, const vector<K> &keys, const vector<K> &shuffled, int query_count, mt19937_64 &rng) {
+    int n = int(keys.size());
+    auto record = [&](Pattern pattern, const char *operation, double ns) { ::record({container, key_name, n, pattern, operation, ns}); };
+    constexpr bool ORDER_STATISTICS = requires(Set set, K key) { set.order_of_key(key); };
+    constexpr bool ITERATOR_ARITHMETIC = requires(typename Set::Iterator it) { it + 1; };
+    constexpr bool SCAN = requires(Set set) { set.for_each([](const K &) {}); };
+    
+    for (Pattern pattern: {Pattern::SEQUENTIAL, Pattern::RANDOM, Pattern::ZIPF}) {
+        // Inserting and erasing all n keys in order, in a random order, or n Zipfian draws (mostly repeats).
+        vector<int> indices = make_indices(pattern, n, n, rng);
+        auto key_at = [&](size_t i) -> const K & { return pattern == Pattern::RANDOM ? shuffled[i] : keys[indices[i]]; };
+        {
+            Set set;
+            record(pattern, "insert", time_per_call(n, [&](size_t i) { return set.insert(key_at(i)).second; }));
+        }
+        {
+            Set set;
+            fill(set, shuffled);
+            record(pattern, "erase", time_per_call(n, [&](size_t i) { return (long long) set.erase(key_at(i)); }));
+        }
+    }
+    
+    Set set;
+    fill(set, shuffled);
+    
+    for (Pattern pattern: {Pattern::SEQUENTIAL, Pattern::RANDOM, Pattern::ZIPF}) {
+        vector<int> indices = make_indices(pattern, n, query_count, rng);
+        record(pattern, "find", time_per_call(query_count, [&](size_t i) { return set.find(keys[indices[i]]) != set.end(); }));
+        record(pattern, "lower_bound", time_per_call(query_count, [&](size_t i) {
+            auto it = set.lower_bound(keys[indices[i]]);
+            return it != set.end() ? digest(*it) : 0;
+        }));
+        if constexpr (ORDER_STATISTICS) {
+            record(pattern, "order_of_key", time_per_call(query_count, [&](size_t i) { return set.order_of_key(keys[indices[i]]); }));
+            record(pattern, "find_by_order", time_per_call(query_count, [&](size_t i) { return digest(*set.find_by_order(indices[i])); }));
+        }
+        if constexpr (ITERATOR_ARITHMETIC) {
+            // Hops from the current position to the next index, so sequential hops are short and the others mostly long.
+            typename Set::Iterator it = set.begin();
+            int order = 0;
+            record(pattern, "iterator_advance", time_per_call(query_count, [&](size_t i) {
+                it = it + (indices[i] - order);
+                order = indices[i];
+                return digest(*it);
+            }));
+        }
+    }
+    
+    record(Pattern::SEQUENTIAL, "iterate", time_per_call(1, [&](size_t) {
+        long long sum = 0;
+        for (auto it = set.begin(); it != set.end(); ++it) sum += digest(*it);
+        return sum;
+    }) / n);
+    if constexpr (SCAN) {
+        record(Pattern::SEQUENTIAL, "for_each", time_per_call(1, [&](size_t) {
+            long long sum = 0;
+            set.for_each([&](const K &key) { sum += digest(key); });
+            return sum;
+        }) / n);
+    }
+}
+
+template<typename K>
+void run_key(const char *key_name, int n, int query_count, mt19937_64 &rng) {
+    vector<K> keys(n);
+    for (int i = 0; i < n; i++) keys[i] = make_key<K>(i, rng);
+    vector<K> shuffled = keys;
+    shuffle(shuffled.begin(), shuffled.end(), rng);
+    
+    run<ordered_set<K>>("ordered_set", key_name, keys, shuffled, query_count, rng);
+    run<set<K>>("std::set", key_name, keys, shuffled, query_count, rng);
+    run<pbds_tree<K>>("pbds_tree", key_name, keys, shuffled, query_count, rng);
+}
+
+void print(bool json) {
+    if (json) puts("[");
+    else puts("container,key,size,pattern,operation,ns_per_op");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        if (json) {
+            printf("  {\"container\": \"%s\", \"key\": \"%s\", \"size\": %d, \"pattern\": \"%s\", \"operation\": \"%s\", \"ns_per_op\": %.2f}%s\n",
+                   r.container.c_str(), r.key.c_str(), r.size, pattern_name(r.pattern), r.operation.c_str(), r.ns, i + 1 < results.size() ? "," : "");
+        } else {
+            printf("%s,%s,%d,%s,%s,%.2f\n", r.container.c_str(), r.key.c_str(), r.size, pattern_name(r.pattern), r.operation.c_str(), r.ns);
+        }
+    }
+    if (json) puts("]");
+}
+
+int main(int argc, char **argv) {
+    bool json = false;
+    long long max_size = 1000000;
+    int query_count = 1000000, repeat = 1;
+    unsigned long long seed = 42;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--format=json") json = true;
+        else if (arg == "--format=csv") json = false;
+        else if (arg.starts_with("--max-size=")) max_size = stoll(arg.substr(11));
+        else if (arg.starts_with("--queries=")) query_count = stoi(arg.substr(10));
+        else if (arg.starts_with("--repeat=")) repeat = stoi(arg.substr(9));
+        else if (arg.starts_with("--seed=")) seed = stoull(arg.substr(7));
+        else {
+            fprintf(stderr, "Usage: %s [--format=csv|json] [--max-size=1000000] [--queries=1000000] [--repeat=1] [--seed=42]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    mt19937_64 rng(seed);
+    for (long long n = 1000; n <= max_size; n *= 10) {
+        fprintf(stderr, "size %lld\n", n);
+        for (int i = 0; i < repeat; i++) {
+            run_key<long long>("int64", int(n), query_count, rng);
+            run_key<string>("string", int(n), query_count, rng);
+        }
+    }
+    print(json);
+}
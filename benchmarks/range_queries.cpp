@@ -0,0 +1,88 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// count_in_range, kth_at_or_after and quantile_in_range against the order_of_key and find_by_order calls they fuse, on a set of size random 64-bit keys.
+// Ranges start at a random key and span about width keys, for a narrow, a middling and a wide width, so the two paths share more or less of their top.
+// Prints the fastest of repeat runs in nanoseconds per query, and the comparisons per query counted by a stats_policy copy of the same queries.
+// Usage: range_queries [size = 1000000] [queries = 1000000] [repeat = 3]
+//
+
+#include "../ordered_set.cpp"
+
+using Clock = chrono::steady_clock;
+
+struct Result {
+    double ns, comparisons;
+};
+
+struct Query {
+    long long lo, hi;
+    unsigned k;
+    double q;
+};
+
+// Runs f on every query, fastest of repeat runs, then once more on a counting copy of the set.
+template<typename Set, typename Counted, typename F>
+Result measure(const Set &set, Counted &counted, const vector<Query> &queries, int repeat, F f) {
+    double ns = numeric_limits<double>::max();
+    for (int i = 0; i < repeat; i++) {
+        long long checksum = 0;
+        auto start = Clock::now();
+        for (const Query &query: queries) checksum += f(set, query);
+        ns = min(ns, chrono::duration<double, nano>(Clock::now() - start).count() / double(queries.size()));
+        if (checksum == 42) puts("");
+    }
+    counted.reset_stats();
+    for (const Query &query: queries) f(counted, query);
+    return {ns, double(counted.stats().comparisons) / double(queries.size())};
+}
+
+int main(int argc, char **argv) {
+    int size = argc > 1 ? atoi(argv[1]) : 1000000;
+    int query_count = argc > 2 ? atoi(argv[2]) : 1000000;
+    int repeat = argc > 3 ? atoi(argv[3]) : 3;
+    
+    // Keys step by 16 on average, so a range of width keys spans about 16 * width.
+    mt19937_64 rng(42);
+    ordered_set<long long> set;
+    ordered_set<long long, less<long long>, allocator<long long>, stats_policy<>> counted;
+    for (int i = 0; i < size; i++) {
+        auto key = (long long) (rng() % (16ULL * size));
+        set.insert(key);
+        counted.insert(key);
+    }
+    
+    auto digest = [](const auto &set, auto it) { return it != set.end() ? *it : 0; };
+    auto count_fused = [](const auto &set, const Query &query) { return (long long) set.count_in_range(query.lo, query.hi); };
+    auto count_composed = [](const auto &set, const Query &query) { return (long long) (set.order_of_key(query.hi) - set.order_of_key(query.lo)); };
+    auto kth_fused = [&](const auto &set, const Query &query) { return digest(set, set.kth_at_or_after(query.lo, query.k)); };
+    auto kth_composed = [&](const auto &set, const Query &query) {
+        auto order = set.order_of_key(query.lo) + query.k;
+        return order < set.size() ? digest(set, set.find_by_order(order)) : 0;
+    };
+    auto quantile_fused = [&](const auto &set, const Query &query) { return digest(set, set.quantile_in_range(query.lo, query.hi, query.q)); };
+    auto quantile_composed = [&](const auto &set, const Query &query) {
+        auto lo = set.order_of_key(query.lo), count = set.order_of_key(query.hi) - lo;
+        if (!count) return 0LL;
+        auto rank = decltype(count)(ceil(query.q * double(count)));
+        return digest(set, set.find_by_order(lo + (rank ? min(rank, count) - 1 : 0)));
+    };
+    
+    printf("%-10s %-10s %12s %12s %12s %12s\n", "width", "query", "fused ns", "composed ns", "fused cmp", "composed cmp");
+    for (int width: {16, size / 100, size / 2}) {
+        uniform_real_distribution<double> uniform(0, 1);
+        vector<Query> queries(query_count);
+        for (Query &query: queries) {
+            query.lo = (long long) (rng() % (16ULL * size));
+            query.hi = query.lo + (long long) (rng() % (32ULL * width + 1));
+            query.k = unsigned(rng() % (2ULL * width + 1));
+            query.q = uniform(rng);
+        }
+        auto row = [&](const char *name, Result fused, Result composed) {
+            printf("%-10d %-10s %12.1f %12.1f %12.2f %12.2f\n", width, name, fused.ns, composed.ns, fused.comparisons, composed.comparisons);
+        };
+        row("count", measure(set, counted, queries, repeat, count_fused), measure(set, counted, queries, repeat, count_composed));
+        row("kth", measure(set, counted, queries, repeat, kth_fused), measure(set, counted, queries, repeat, kth_composed));
+        row("quantile", measure(set, counted, queries, repeat, quantile_fused), measure(set, counted, queries, repeat, quantile_composed));
+    }
+}
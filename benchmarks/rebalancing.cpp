@@ -0,0 +1,68 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Bottom-up against single-pass rebalancing of ordered_set under mixed inserts and erases of random 64-bit keys, around a steady size.
+// Keys are drawn from twice the size, so about half the calls find their key, and each workload inserts a given share of the time and erases otherwise.
+// Prints the fastest of repeat runs in nanoseconds per operation, and the comparisons and rotations per operation counted by a stats_policy copy of the same run.
+// Usage: rebalancing [size = 1000000] [operations = 4000000] [repeat = 3]
+//
+
+#include "../ordered_set.cpp"
+
+using Clock = chrono::steady_clock;
+
+struct single_pass_policy : tree_policy { using rebalancing = single_pass_rebalancing; };
+
+struct Result {
+    double ns, comparisons, rotations;
+};
+
+template<typename Policy>
+Result run(int size, int operations, int repeat, double insert_share) {
+    mt19937_64 rng(42);
+    bernoulli_distribution coin(insert_share);
+    vector<pair<long long, bool>> calls(operations);
+    for (auto &[key, insert]: calls) {
+        key = (long long) (rng() % (2 * size));
+        insert = coin(rng);
+    }
+    auto fill = [&](auto &set) {
+        mt19937_64 fill_rng(7);
+        for (int i = 0; i < size; i++) set.insert((long long) (fill_rng() % (2 * size)));
+    };
+    auto play = [&](auto &set) {
+        long long checksum = 0;
+        for (auto [key, insert]: calls) checksum += insert ? set.insert(key).second : set.erase(key);
+        return checksum;
+    };
+    
+    double ns = numeric_limits<double>::max();
+    for (int i = 0; i < repeat; i++) {
+        ordered_set<long long, less<long long>, allocator<long long>, Policy> set;
+        fill(set);
+        auto start = Clock::now();
+        if (play(set) == 42) puts("");
+        ns = min(ns, chrono::duration<double, nano>(Clock::now() - start).count() / operations);
+    }
+    
+    ordered_set<long long, less<long long>, allocator<long long>, stats_policy<Policy>> counted;
+    fill(counted);
+    counted.reset_stats();
+    play(counted);
+    ordered_set_stats stats = counted.stats();
+    return {ns, double(stats.comparisons) / operations, double(stats.rotations) / operations};
+}
+
+int main(int argc, char **argv) {
+    int size = argc > 1 ? atoi(argv[1]) : 1000000;
+    int operations = argc > 2 ? atoi(argv[2]) : 4000000;
+    int repeat = argc > 3 ? atoi(argv[3]) : 3;
+    
+    printf("%-8s %14s %14s %14s %14s %14s %14s\n", "inserts", "bottom-up ns", "single-pass ns", "bu compares", "sp compares", "bu rotations", "sp rotations");
+    for (double share: {0.25, 0.5, 0.75}) {
+        Result bottom_up = run<tree_policy>(size, operations, repeat, share);
+        Result single_pass = run<single_pass_policy>(size, operations, repeat, share);
+        printf("%7.0f%% %14.1f %14.1f %14.2f %14.2f %14.3f %14.3f\n", share * 100, bottom_up.ns, single_pass.ns,
+               bottom_up.comparisons, single_pass.comparisons, bottom_up.rotations, single_pass.rotations);
+    }
+}
@@ -0,0 +1,62 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// A rolling window of the last size random 64-bit keys: sliding_window::push against inserting into an ordered_multiset and erasing the expired key by value,
+// and expiring most of a full window with one advance against one key at a time. Prints nanoseconds per key, the fastest of repeat runs.
+// Usage: sliding_window [size = 100000] [pushes = 2000000] [repeat = 3]
+//
+
+#include "../sliding_window.cpp"
+
+using Clock = chrono::steady_clock;
+
+// Returns the nanoseconds f took, divided by count.
+template<typename F>
+double time_per_key(size_t count, F f) {
+    auto start = Clock::now();
+    f();
+    return chrono::duration<double, nano>(Clock::now() - start).count() / double(count);
+}
+
+int main(int argc, char **argv) {
+    int size = argc > 1 ? atoi(argv[1]) : 100000;
+    int pushes = argc > 2 ? atoi(argv[2]) : 2000000;
+    int repeat = argc > 3 ? atoi(argv[3]) : 3;
+    
+    mt19937_64 rng(42);
+    vector<long long> keys(size + pushes);
+    for (long long &key: keys) key = (long long) (rng() >> 1);
+    
+    double window_ns = 1e18, by_value_ns = 1e18, batch_ns = 1e18, single_ns = 1e18;
+    for (int r = 0; r < repeat; r++) {
+        sliding_window<long long> window(size);
+        for (int i = 0; i < size; i++) window.push(keys[i]);
+        window_ns = min(window_ns, time_per_key(pushes, [&] { for (int i = size; i < size + pushes; i++) window.push(keys[i]); }));
+        
+        ordered_multiset<long long> set;
+        deque<long long> arrivals;
+        for (int i = 0; i < size; i++) set.insert(keys[i]), arrivals.push_back(keys[i]);
+        by_value_ns = min(by_value_ns, time_per_key(pushes, [&] {
+            for (int i = size; i < size + pushes; i++) {
+                set.insert(keys[i]);
+                arrivals.push_back(keys[i]);
+                set.erase(arrivals.front());
+                arrivals.pop_front();
+            }
+        }));
+        
+        // Expiring 90% of the window: rebuilt over the rest in one pass, or erased one key at a time.
+        int expired = size / 10 * 9;
+        window.clear();
+        for (int i = 0; i < size; i++) window.push(keys[i]);
+        batch_ns = min(batch_ns, time_per_key(expired, [&] { window.advance(expired); }));
+        window.clear();
+        for (int i = 0; i < size; i++) window.push(keys[i]);
+        single_ns = min(single_ns, time_per_key(expired, [&] { for (int i = 0; i < expired; i++) window.advance(1); }));
+    }
+    printf("%-32s %10s\n", "", "ns per key");
+    printf("%-32s %10.1f\n", "sliding_window push", window_ns);
+    printf("%-32s %10.1f\n", "multiset insert + erase(key)", by_value_ns);
+    printf("%-32s %10.1f\n", "advance(90% of the window)", batch_ns);
+    printf("%-32s %10.1f\n", "advance(1), 90% of the window", single_ns);
+}
@@ -0,0 +1,602 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#include "btree_ordered_set.h"
+
+#define TEMPLATE template<typename T, int B, typename Allocator>
+#define BTREE_ORDERED_SET btree_ordered_set<T, B, Allocator>
+#define iterator typename BTREE_ORDERED_SET::Iterator
+
+
+TEMPLATE
+BTREE_ORDERED_SET::btree_ordered_set(const Allocator &alloc) : leaf_alloc_(alloc), inner_alloc_(alloc) {}
+
+TEMPLATE
+BTREE_ORDERED_SET::btree_ordered_set(initializer_list<T> values) : btree_ordered_set(values.begin(), values.end()) {}
+
+// Builds the tree bottom-up in O(n) if [first, last) is sorted, O(n log(n)) otherwise.
+TEMPLATE
+template<typename InputIt>
+BTREE_ORDERED_SET::btree_ordered_set(InputIt first, InputIt last) {
+    vector<T> values(first, last);
+    if (!is_sorted(values.begin(), values.end())) sort(values.begin(), values.end());
+    values.erase(unique(values.begin(), values.end()), values.end());
+    build(values);
+}
+
+TEMPLATE
+BTREE_ORDERED_SET::btree_ordered_set(btree_ordered_set &&other) noexcept
+        : root_(exchange(other.root_, nullptr)), height_(exchange(other.height_, 0)), size_(exchange(other.size_, 0)),
+          leaves_(exchange(other.leaves_, 0)), inners_(exchange(other.inners_, 0)),
+          leaf_alloc_(other.leaf_alloc_), inner_alloc_(other.inner_alloc_) {}
+
+TEMPLATE
+BTREE_ORDERED_SET &BTREE_ORDERED_SET::operator=(btree_ordered_set &&other) noexcept {
+    if (this != &other) {
+        clear();
+        root_ = exchange(other.root_, nullptr);
+        height_ = exchange(other.height_, 0);
+        size_ = exchange(other.size_, 0);
+        leaves_ = exchange(other.leaves_, 0);
+        inners_ = exchange(other.inners_, 0);
+        leaf_alloc_ = other.leaf_alloc_;
+        inner_alloc_ = other.inner_alloc_;
+    }
+    return *this;
+}
+
+TEMPLATE
+BTREE_ORDERED_SET::~btree_ordered_set() { clear(); }
+
+
+// Tree Properties
+
+TEMPLATE
+typename BTREE_ORDERED_SET::size_type BTREE_ORDERED_SET::size() const { return size_; }
+
+TEMPLATE
+bool BTREE_ORDERED_SET::empty() const { return size_ == 0; }
+
+// Returns the bytes held by the set, nodes included.
+TEMPLATE
+size_t BTREE_ORDERED_SET::memory_usage() const { return sizeof(*this) + leaves_ * sizeof(Leaf) + inners_ * sizeof(Inner); }
+
+TEMPLATE
+void BTREE_ORDERED_SET::clear() {
+    if (root_) free_subtree(root_, height_);
+    root_ = nullptr;
+    height_ = size_ = 0;
+}
+
+
+// Getting
+
+TEMPLATE
+const T &BTREE_ORDERED_SET::operator[](size_type index) const { return *find_by_order(index); }
+
+// Returns an iterator to the smallest element.
+TEMPLATE
+iterator BTREE_ORDERED_SET::begin() const { return find_by_order(0); }
+
+// Returns past-the-end (end()) iterator.
+TEMPLATE
+iterator BTREE_ORDERED_SET::end() const { return Iterator(this, nullptr, 0, size_); }
+
+// Returns an iterator to the element equal to key, or end() if there is none.
+TEMPLATE
+iterator BTREE_ORDERED_SET::find(T key) const {
+    Iterator it = lower_bound(key);
+    return it.leaf_ && it.leaf_->keys[it.pos_] == key ? it : end();
+}
+
+// Returns an iterator to the smallest element not less than key.
+TEMPLATE
+iterator BTREE_ORDERED_SET::lower_bound(T key) const { return search<false>(key); }
+
+// Returns an iterator to the smallest element greater than key.
+TEMPLATE
+iterator BTREE_ORDERED_SET::upper_bound(T key) const { return search<true>(key); }
+
+// Returns an iterator to the k-th smallest element (0-indexed), or end() if k == size().
+// A negative order converted to size_type lands far above size() and throws like any other.
+TEMPLATE
+iterator BTREE_ORDERED_SET::find_by_order(size_type k) const {
+    if (k > size_) throw out_of_range("Order out of range.");
+    if (k == size_) return end();
+    
+    size_type order = k;
+    const Node *u = root_;
+    for (int h = height_; h > 0; h--) {
+        auto in = static_cast<const Inner *>(u);
+        int i = 0;
+        while (k >= in->counts[i]) k -= in->counts[i++];
+        u = in->children[i];
+    }
+    return Iterator(this, static_cast<const Leaf *>(u), k, order);
+}
+
+// Returns the number of elements less than key.
+TEMPLATE
+typename BTREE_ORDERED_SET::size_type BTREE_ORDERED_SET::order_of_key(T key) const { return search<false>(key).order_; }
+
+
+// Inserting
+
+// Splits full nodes on the way down, so the key always fits in its leaf and nothing propagates back up.
+// Returns an iterator to key, and whether it was inserted.
+TEMPLATE
+pair<iterator, bool> BTREE_ORDERED_SET::insert(T key) {
+    if (!root_) root_ = new_leaf();
+    if (root_->size == B) {
+        Inner *root = new_inner();
+        root->size = 1;
+        root->children[0] = root_;
+        root->counts[0] = size_;
+        root_ = root;
+        split_child(root, 0, height_++);
+    }
+    
+    Inner *path[MAX_HEIGHT];
+    int index[MAX_HEIGHT];
+    size_type order = 0;
+    Node *u = root_;
+    for (int h = height_; h > 0; h--) {
+        auto in = static_cast<Inner *>(u);
+        int i = count_less_equal(in->keys, in->size - 1, key);
+        if (in->children[i]->size == B) {
+            split_child(in, i, h - 1);
+            if (!(key < in->keys[i])) i++;
+        }
+        for (int j = 0; j < i; j++) order += in->counts[j];
+        path[height_ - h] = in;
+        index[height_ - h] = i;
+        u = in->children[i];
+    }
+    
+    auto leaf = static_cast<Leaf *>(u);
+    int pos = count_less(leaf->keys, leaf->size, key);
+    if (pos < leaf->size && leaf->keys[pos] == key) return {Iterator(this, leaf, pos, order + pos), false};
+    
+    move_backward(leaf->keys + pos, leaf->keys + leaf->size, leaf->keys + leaf->size + 1);
+    leaf->keys[pos] = std::move(key);
+    leaf->size++;
+    for (int d = 0; d < height_; d++) path[d]->counts[index[d]]++;
+    size_++;
+    return {Iterator(this, leaf, pos, order + pos), true};
+}
+
+
+// Erasing
+
+// Tops up minimal nodes on the way down, by borrowing from or merging with a sibling, so the leaf can always lose a key.
+// Returns whether key was erased.
+TEMPLATE
+bool BTREE_ORDERED_SET::erase(T key) {
+    if (!root_) return false;
+    
+    Inner *path[MAX_HEIGHT];
+    int index[MAX_HEIGHT];
+    Node *u = root_;
+    for (int h = height_; h > 0; h--) {
+        auto in = static_cast<Inner *>(u);
+        int i = count_less_equal(in->keys, in->size - 1, key);
+        if (in->children[i]->size == B / 2) i = refill_child(in, i, h - 1);
+        path[height_ - h] = in;
+        index[height_ - h] = i;
+        u = in->children[i];
+    }
+    
+    auto leaf = static_cast<Leaf *>(u);
+    int pos = count_less(leaf->keys, leaf->size, key);
+    bool erased = pos < leaf->size && leaf->keys[pos] == key;
+    if (erased) {
+        move(leaf->keys + pos + 1, leaf->keys + leaf->size, leaf->keys + pos);
+        leaf->size--;
+        for (int d = 0; d < height_; d++) path[d]->counts[index[d]]--;
+        size_--;
+    }
+    
+    // Merges below the root may have left it with a single child.
+    while (height_ > 0 && root_->size == 1) {
+        Node *child = static_cast<Inner *>(root_)->children[0];
+        free_node(root_, height_--);
+        root_ = child;
+    }
+    if (height_ == 0 && root_->size == 0) {
+        free_node(root_, 0);
+        root_ = nullptr;
+    }
+    return erased;
+}
+
+
+// Node Functions
+
+// Returns the number of keys in keys[0, n) less than key.
+TEMPLATE
+int BTREE_ORDERED_SET::count_less(const T *keys, int n, const T &key) {
+    if constexpr (is_arithmetic_v<T>) return count_compared<false>(keys, n, key);
+    else return int(std::lower_bound(keys, keys + n, key) - keys);
+}
+
+// Returns the number of keys in keys[0, n) not greater than key.
+TEMPLATE
+int BTREE_ORDERED_SET::count_less_equal(const T *keys, int n, const T &key) {
+    if constexpr (is_arithmetic_v<T>) return count_compared<true>(keys, n, key);
+    else return int(std::upper_bound(keys, keys + n, key) - keys);
+}
+
+// Counts the arithmetic keys in keys[0, n) less than (not greater than if OrEqual) key, by comparing against all of them.
+// A node is a few cache lines, so this is cheaper than a binary search's mispredicted branches: with AVX2, 32 and 64-bit keys
+// are compared 8 or 4 at a time and the comparison masks popcounted, otherwise the compiler gets a branchless loop to vectorize.
+TEMPLATE
+template<bool OrEqual>
+int BTREE_ORDERED_SET::count_compared(const T *keys, int n, T key) {
+    int count = 0, i = 0;
+#ifdef __AVX2__
+    if constexpr (is_same_v<T, double>) {
+        __m256d k = _mm256_set1_pd(key);
+        for (; i + 4 <= n; i += 4) {
+            __m256d less = _mm256_cmp_pd(_mm256_loadu_pd(keys + i), k, OrEqual ? _CMP_LE_OQ : _CMP_LT_OQ);
+            count += popcount(unsigned(_mm256_movemask_pd(less)));
+        }
+    } else if constexpr (is_same_v<T, float>) {
+        __m256 k = _mm256_set1_ps(key);
+        for (; i + 8 <= n; i += 8) {
+            __m256 less = _mm256_cmp_ps(_mm256_loadu_ps(keys + i), k, OrEqual ? _CMP_LE_OQ : _CMP_LT_OQ);
+            count += popcount(unsigned(_mm256_movemask_ps(less)));
+        }
+    } else if constexpr (is_integral_v<T> && (sizeof(T) == 8 || sizeof(T) == 4)) {
+        // AVX2 only compares signed integers, flipping the sign bit orders unsigned ones the same way.
+        constexpr int LANES = 32 / sizeof(T);
+        using S = make_signed_t<T>;
+        constexpr S FLIP = is_signed_v<T> ? 0 : numeric_limits<S>::min();
+        __m256i k = sizeof(T) == 8 ? _mm256_set1_epi64x(S(key) ^ FLIP) : _mm256_set1_epi32(S(key) ^ FLIP);
+        __m256i flip = sizeof(T) == 8 ? _mm256_set1_epi64x(FLIP) : _mm256_set1_epi32(FLIP);
+        for (; i + LANES <= n; i += LANES) {
+            __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)), flip);
+            // Less than key is key > v, not greater than key is not v > key.
+            __m256i mask = sizeof(T) == 8 ? (OrEqual ? _mm256_cmpgt_epi64(v, k) : _mm256_cmpgt_epi64(k, v))
+                                          : (OrEqual ? _mm256_cmpgt_epi32(v, k) : _mm256_cmpgt_epi32(k, v));
+            int set = popcount(unsigned(_mm256_movemask_epi8(mask))) / int(sizeof(T));
+            count += OrEqual ? LANES - set : set;
+        }
+    }
+#endif
+    for (; i < n; i++) count += OrEqual ? !(key < keys[i]) : keys[i] < key;
+    return count;
+}
+
+TEMPLATE
+typename BTREE_ORDERED_SET::size_type BTREE_ORDERED_SET::subtree_size(const Inner *u) { return accumulate(u->counts, u->counts + u->size, size_type(0)); }
+
+// Finds the first key not less than (greater than if Strict) key.
+// Both descend into the child whose separators bound key, only the leaf tells them apart.
+TEMPLATE
+template<bool Strict>
+iterator BTREE_ORDERED_SET::search(const T &key) const {
+    if (!root_) return end();
+    
+    size_type order = 0;
+    const Node *u = root_;
+    for (int h = height_; h > 0; h--) {
+        auto in = static_cast<const Inner *>(u);
+        int i = count_less_equal(in->keys, in->size - 1, key);
+        for (int j = 0; j < i; j++) order += in->counts[j];
+        u = in->children[i];
+    }
+    
+    auto leaf = static_cast<const Leaf *>(u);
+    int pos = Strict ? count_less_equal(leaf->keys, leaf->size, key) : count_less(leaf->keys, leaf->size, key);
+    order += pos;
+    if (pos < leaf->size) return Iterator(this, leaf, pos, order);
+    return leaf->next ? Iterator(this, leaf->next, 0, order) : end();
+}
+
+TEMPLATE
+typename BTREE_ORDERED_SET::Leaf *BTREE_ORDERED_SET::new_leaf() {
+    Leaf *u = allocator_traits<leaf_allocator>::allocate(leaf_alloc_, 1);
+    allocator_traits<leaf_allocator>::construct(leaf_alloc_, u);
+    leaves_++;
+    return u;
+}
+
+TEMPLATE
+typename BTREE_ORDERED_SET::Inner *BTREE_ORDERED_SET::new_inner() {
+    Inner *u = allocator_traits<inner_allocator>::allocate(inner_alloc_, 1);
+    allocator_traits<inner_allocator>::construct(inner_alloc_, u);
+    inners_++;
+    return u;
+}
+
+// Frees u alone, height telling whether it is a leaf.
+TEMPLATE
+void BTREE_ORDERED_SET::free_node(Node *u, int height) {
+    if (height == 0) {
+        allocator_traits<leaf_allocator>::destroy(leaf_alloc_, static_cast<Leaf *>(u));
+        allocator_traits<leaf_allocator>::deallocate(leaf_alloc_, static_cast<Leaf *>(u), 1);
+        leaves_--;
+    } else {
+        allocator_traits<inner_allocator>::destroy(inner_alloc_, static_cast<Inner *>(u));
+        allocator_traits<inner_allocator>::deallocate(inner_alloc_, static_cast<Inner *>(u), 1);
+        inners_--;
+    }
+}
+
+TEMPLATE
+void BTREE_ORDERED_SET::free_subtree(Node *u, int height) {
+    if (height > 0) {
+        auto in = static_cast<Inner *>(u);
+        for (int i = 0; i < in->size; i++) free_subtree(in->children[i], height - 1);
+    }
+    free_node(u, height);
+}
+
+// Splits u's full i-th child, whose height is given, into two halves, adding the right one to u after it.
+// u must not be full.
+TEMPLATE
+void BTREE_ORDERED_SET::split_child(Inner *u, int i, int height) {
+    Node *right;
+    T separator;
+    size_type moved;
+    if (height == 0) {
+        auto l = static_cast<Leaf *>(u->children[i]);
+        Leaf *r = new_leaf();
+        move(l->keys + B / 2, l->keys + B, r->keys);
+        l->size = r->size = B / 2;
+        r->prev = l;
+        r->next = l->next;
+        if (r->next) r->next->prev = r;
+        l->next = r;
+        separator = r->keys[0];
+        moved = r->size;
+        right = r;
+    } else {
+        auto l = static_cast<Inner *>(u->children[i]);
+        Inner *r = new_inner();
+        move(l->keys + B / 2, l->keys + B - 1, r->keys);
+        copy(l->counts + B / 2, l->counts + B, r->counts);
+        copy(l->children + B / 2, l->children + B, r->children);
+        separator = std::move(l->keys[B / 2 - 1]);
+        l->size = r->size = B / 2;
+        moved = subtree_size(r);
+        right = r;
+    }
+    
+    move_backward(u->keys + i, u->keys + u->size - 1, u->keys + u->size);
+    copy_backward(u->counts + i + 1, u->counts + u->size, u->counts + u->size + 1);
+    copy_backward(u->children + i + 1, u->children + u->size, u->children + u->size + 1);
+    u->keys[i] = std::move(separator);
+    u->children[i + 1] = right;
+    u->counts[i + 1] = moved;
+    u->counts[i] -= moved;
+    u->size++;
+}
+
+// Gives u's minimal i-th child, whose height is given, one more entry, from a sibling that can spare one or by merging with a sibling.
+// Returns the index the child ends up at.
+TEMPLATE
+int BTREE_ORDERED_SET::refill_child(Inner *u, int i, int height) {
+    if (i > 0 && u->children[i - 1]->size > B / 2) {
+        size_type moved;
+        if (height == 0) {
+            auto l = static_cast<Leaf *>(u->children[i - 1]), c = static_cast<Leaf *>(u->children[i]);
+            move_backward(c->keys, c->keys + c->size, c->keys + c->size + 1);
+            c->keys[0] = std::move(l->keys[l->size - 1]);
+            u->keys[i - 1] = c->keys[0];
+            moved = 1;
+        } else {
+            auto l = static_cast<Inner *>(u->children[i - 1]), c = static_cast<Inner *>(u->children[i]);
+            move_backward(c->keys, c->keys + c->size - 1, c->keys + c->size);
+            copy_backward(c->counts, c->counts + c->size, c->counts + c->size + 1);
+            copy_backward(c->children, c->children + c->size, c->children + c->size + 1);
+            c->keys[0] = std::move(u->keys[i - 1]);
+            c->counts[0] = l->counts[l->size - 1];
+            c->children[0] = l->children[l->size - 1];
+            u->keys[i - 1] = std::move(l->keys[l->size - 2]);
+            moved = c->counts[0];
+        }
+        u->children[i - 1]->size--;
+        u->children[i]->size++;
+        u->counts[i - 1] -= moved;
+        u->counts[i] += moved;
+        return i;
+    }
+    
+    if (i + 1 < u->size && u->children[i + 1]->size > B / 2) {
+        size_type moved;
+        if (height == 0) {
+            auto c = static_cast<Leaf *>(u->children[i]), r = static_cast<Leaf *>(u->children[i + 1]);
+            c->keys[c->size] = std::move(r->keys[0]);
+            move(r->keys + 1, r->keys + r->size, r->keys);
+            u->keys[i] = r->keys[0];
+            moved = 1;
+        } else {
+            auto c = static_cast<Inner *>(u->children[i]), r = static_cast<Inner *>(u->children[i + 1]);
+            c->keys[c->size - 1] = std::move(u->keys[i]);
+            c->counts[c->size] = r->counts[0];
+            c->children[c->size] = r->children[0];
+            u->keys[i] = std::move(r->keys[0]);
+            move(r->keys + 1, r->keys + r->size - 1, r->keys);
+            copy(r->counts + 1, r->counts + r->size, r->counts);
+            copy(r->children + 1, r->children + r->size, r->children);
+            moved = c->counts[c->size];
+        }
+        u->children[i]->size++;
+        u->children[i + 1]->size--;
+        u->counts[i] += moved;
+        u->counts[i + 1] -= moved;
+        return i;
+    }
+    
+    if (i > 0) {
+        merge_children(u, i - 1, height);
+        return i - 1;
+    }
+    merge_children(u, i, height);
+    return i;
+}
+
+// Merges u's i-th and i + 1-th children, both minimal, into the i-th.
+TEMPLATE
+void BTREE_ORDERED_SET::merge_children(Inner *u, int i, int height) {
+    if (height == 0) {
+        auto l = static_cast<Leaf *>(u->children[i]), r = static_cast<Leaf *>(u->children[i + 1]);
+        move(r->keys, r->keys + r->size, l->keys + l->size);
+        l->size += r->size;
+        l->next = r->next;
+        if (l->next) l->next->prev = l;
+    } else {
+        auto l = static_cast<Inner *>(u->children[i]), r = static_cast<Inner *>(u->children[i + 1]);
+        l->keys[l->size - 1] = std::move(u->keys[i]);
+        move(r->keys, r->keys + r->size - 1, l->keys + l->size);
+        copy(r->counts, r->counts + r->size, l->counts + l->size);
+        copy(r->children, r->children + r->size, l->children + l->size);
+        l->size += r->size;
+    }
+    free_node(u->children[i + 1], height);
+    
+    u->counts[i] += u->counts[i + 1];
+    move(u->keys + i + 1, u->keys + u->size - 1, u->keys + i);
+    copy(u->counts + i + 2, u->counts + u->size, u->counts + i + 1);
+    copy(u->children + i + 2, u->children + u->size, u->children + i + 1);
+    u->size--;
+}
+
+// Builds the tree level by level from sorted distinct values, spreading each level evenly over as few nodes as fit it.
+TEMPLATE
+void BTREE_ORDERED_SET::build(const vector<T> &values) {
+    clear();
+    if (values.empty()) return;
+    
+    // Each node of a level, along with its subtree size and smallest key.
+    vector<tuple<Node *, size_type, const T *>> level;
+    size_t n = values.size(), m = (n + B - 1) / B;
+    Leaf *prev = nullptr;
+    for (size_t j = 0; j < m; j++) {
+        size_t first = n * j / m, last = n * (j + 1) / m;
+        Leaf *leaf = new_leaf();
+        copy(values.begin() + first, values.begin() + last, leaf->keys);
+        leaf->size = int(last - first);
+        leaf->prev = prev;
+        if (prev) prev->next = leaf;
+        prev = leaf;
+        level.emplace_back(leaf, leaf->size, &values[first]);
+    }
+    
+    for (; level.size() > 1; height_++) {
+        vector<tuple<Node *, size_type, const T *>> parents;
+        n = level.size(), m = (n + B - 1) / B;
+        for (size_t j = 0; j < m; j++) {
+            size_t first = n * j / m, last = n * (j + 1) / m;
+            Inner *in = new_inner();
+            in->size = int(last - first);
+            for (size_t t = first; t < last; t++) {
+                auto [child, count, min] = level[t];
+                in->children[t - first] = child;
+                in->counts[t - first] = count;
+                if (t > first) in->keys[t - first - 1] = *min;
+            }
+            parents.emplace_back(in, subtree_size(in), get<2>(level[first]));
+        }
+        level = std::move(parents);
+    }
+    root_ = get<0>(level[0]);
+    size_ = values.size();
+}
+
+
+// Iterator Functions
+
+TEMPLATE
+BTREE_ORDERED_SET::Iterator::Iterator(const btree_ordered_set *tree, const Leaf *leaf, int pos, size_type order)
+        : tree_(tree), leaf_(leaf), pos_(pos), order_(order) {}
+
+TEMPLATE
+const T &BTREE_ORDERED_SET::Iterator::operator*() const {
+    if (!leaf_) throw out_of_range("Dereferencing end iterator.");
+    return leaf_->keys[pos_];
+}
+
+TEMPLATE
+const T *BTREE_ORDERED_SET::Iterator::operator->() const {
+    if (!leaf_) throw out_of_range("Dereferencing end iterator.");
+    return &leaf_->keys[pos_];
+}
+
+TEMPLATE
+iterator &BTREE_ORDERED_SET::Iterator::operator++() {
+    if (!leaf_) throw out_of_range("Incrementing end iterator.");
+    if (++pos_ == leaf_->size) {
+        leaf_ = leaf_->next;
+        pos_ = 0;
+    }
+    order_++;
+    return *this;
+}
+
+TEMPLATE
+iterator BTREE_ORDERED_SET::Iterator::operator++(int) {
+    Iterator tmp(*this);
+    ++(*this);
+    return tmp;
+}
+
+TEMPLATE
+iterator &BTREE_ORDERED_SET::Iterator::operator--() {
+    if (order_ == 0) throw out_of_range("Decrementing begin iterator.");
+    if (!leaf_) return *this = tree_->find_by_order(order_ - 1);
+    if (pos_ == 0) {
+        leaf_ = leaf_->prev;
+        pos_ = leaf_->size;
+    }
+    pos_--;
+    order_--;
+    return *this;
+}
+
+TEMPLATE
+iterator BTREE_ORDERED_SET::Iterator::operator--(int) {
+    Iterator tmp(*this);
+    --(*this);
+    return tmp;
+}
+
+
+// Random-Access Iterator
+
+// Stays within the leaf when it can, otherwise descends again in O(log(n)).
+TEMPLATE
+iterator BTREE_ORDERED_SET::Iterator::operator+(difference_type n) const {
+    if (leaf_ && pos_ + n >= 0 && pos_ + n < leaf_->size) return Iterator(tree_, leaf_, int(pos_ + n), order_ + n);
+    return tree_->find_by_order(order_ + n);
+}
+
+TEMPLATE
+iterator BTREE_ORDERED_SET::Iterator::operator-(difference_type n) const { return *this + -n; }
+
+TEMPLATE
+typename BTREE_ORDERED_SET::difference_type BTREE_ORDERED_SET::Iterator::operator-(const Iterator &other) const { return difference_type(order_ - other.order_); }
+
+TEMPLATE
+bool BTREE_ORDERED_SET::Iterator::operator<(const Iterator &other) const { return order_ < other.order_; }
+
+TEMPLATE
+bool BTREE_ORDERED_SET::Iterator::operator<=(const Iterator &other) const { return order_ <= other.order_; }
+
+TEMPLATE
+bool BTREE_ORDERED_SET::Iterator::operator==(const Iterator &other) const { return tree_ == other.tree_ && order_ == other.order_; }
+
+TEMPLATE
+bool BTREE_ORDERED_SET::Iterator::operator!=(const Iterator &other) const { return !(*this == other); }
+
+TEMPLATE
+bool BTREE_ORDERED_SET::Iterator::operator>=(const Iterator &other) const { return order_ >= other.order_; }
+
+TEMPLATE
+bool BTREE_ORDERED_SET::Iterator::operator>(const Iterator &other) const { return order_ > other.order_; }
+
+#undef iterator
+#undef BTREE_ORDERED_SET
+#undef TEMPLATE
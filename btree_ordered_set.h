@@ -0,0 +1,192 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#ifndef ORDERED_SET_BTREE_ORDERED_SET_H
+#define ORDERED_SET_BTREE_ORDERED_SET_H
+
+#include "ordered_set.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// The ordered_set interface on a B+ tree: leaves hold up to B sorted keys, inner nodes up to B children along with the size of each child's subtree.
+// A lookup touches about log_B(n) nodes instead of 2 log2(n), and a key costs little more than itself in memory.
+// Every node but the root stays at least half full. T must be default constructible, as nodes hold arrays of keys.
+// Unlike ordered_set, insert and erase move keys between nodes, so they invalidate all iterators.
+template<typename T, int B = 32, typename Allocator = allocator<T>>
+class btree_ordered_set {
+    static_assert(B >= 4 && B % 2 == 0, "B must be even and at least 4.");
+
+private:
+    class Node;
+    
+    class Leaf;
+    
+    class Inner;
+
+public:
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    
+    class Iterator;
+    
+    btree_ordered_set() = default;
+    
+    explicit btree_ordered_set(const Allocator &alloc);
+    
+    btree_ordered_set(initializer_list<T> values);
+    
+    template<typename InputIt>
+    btree_ordered_set(InputIt first, InputIt last);
+    
+    btree_ordered_set(btree_ordered_set &&other) noexcept;
+    
+    btree_ordered_set &operator=(btree_ordered_set &&other) noexcept;
+    
+    ~btree_ordered_set();
+    
+    [[nodiscard]] size_type size() const;
+    
+    [[nodiscard]] bool empty() const;
+    
+    [[nodiscard]] size_t memory_usage() const;
+    
+    void clear();
+    
+    const T &operator[](size_type index) const;
+    
+    Iterator begin() const;
+    
+    Iterator end() const;
+    
+    Iterator find(T key) const;
+    
+    Iterator lower_bound(T key) const;
+    
+    Iterator upper_bound(T key) const;
+    
+    Iterator find_by_order(size_type k) const;
+    
+    size_type order_of_key(T key) const;
+    
+    pair<Iterator, bool> insert(T key);
+    
+    bool erase(T key);
+    
+    class Iterator {
+        friend class btree_ordered_set;
+
+    public:
+        using iterator_category = bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = btree_ordered_set::difference_type;
+        using pointer = const T *;
+        using reference = const T &;
+        
+        const T &operator*() const;
+        
+        const T *operator->() const;
+        
+        Iterator &operator++();
+        
+        Iterator operator++(int);
+        
+        Iterator &operator--();
+        
+        Iterator operator--(int);
+        
+        Iterator operator+(difference_type n) const;
+        
+        Iterator operator-(difference_type n) const;
+        
+        difference_type operator-(const Iterator &other) const;
+        
+        bool operator<(const Iterator &other) const;
+        
+        bool operator<=(const Iterator &other) const;
+        
+        bool operator==(const Iterator &other) const;
+        
+        bool operator!=(const Iterator &other) const;
+        
+        bool operator>=(const Iterator &other) const;
+        
+        bool operator>(const Iterator &other) const;
+
+    private:
+        const btree_ordered_set *tree_;
+        const Leaf *leaf_; // nullptr at end().
+        int pos_;
+        size_type order_;
+        
+        Iterator(const btree_ordered_set *tree, const Leaf *leaf, int pos, size_type order);
+    };
+
+private:
+    // size is the number of keys in a leaf, and the number of children of an inner node.
+    class Node {
+    public:
+        int size = 0;
+    };
+    
+    class Leaf : public Node {
+    public:
+        T keys[B];
+        Leaf *prev = nullptr, *next = nullptr;
+    };
+    
+    // All keys under children[i] are less than keys[i], which is at most every key under children[i + 1].
+    class Inner : public Node {
+    public:
+        T keys[B - 1];
+        size_type counts[B];
+        Node *children[B];
+    };
+    
+    using leaf_allocator = typename allocator_traits<Allocator>::template rebind_alloc<Leaf>;
+    using inner_allocator = typename allocator_traits<Allocator>::template rebind_alloc<Inner>;
+    
+    // Half-full nodes have at least two children, so no tree with size_type sizes is taller than this.
+    static constexpr int MAX_HEIGHT = numeric_limits<size_type>::digits;
+    
+    Node *root_ = nullptr;
+    int height_ = 0; // Levels of inner nodes above the leaves.
+    size_type size_ = 0;
+    size_t leaves_ = 0, inners_ = 0;
+    leaf_allocator leaf_alloc_;
+    inner_allocator inner_alloc_;
+    
+    // Node Functions
+    
+    static int count_less(const T *keys, int n, const T &key);
+    
+    static int count_less_equal(const T *keys, int n, const T &key);
+    
+    template<bool OrEqual>
+    static int count_compared(const T *keys, int n, T key);
+    
+    static size_type subtree_size(const Inner *u);
+    
+    template<bool Strict>
+    Iterator search(const T &key) const;
+    
+    Leaf *new_leaf();
+    
+    Inner *new_inner();
+    
+    void free_node(Node *u, int height);
+    
+    void free_subtree(Node *u, int height);
+    
+    void split_child(Inner *u, int i, int height);
+    
+    int refill_child(Inner *u, int i, int height);
+    
+    void merge_children(Inner *u, int i, int height);
+    
+    void build(const vector<T> &values);
+};
+
+#endif //ORDERED_SET_BTREE_ORDERED_SET_H
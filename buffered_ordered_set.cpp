@@ -0,0 +1,173 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#include "buffered_ordered_set.h"
+#include "ordered_map.cpp"
+
+#define TEMPLATE template<typename T, typename Compare, typename Allocator, typename Policy>
+#define BUFFERED_ORDERED_SET buffered_ordered_set<T, Compare, Allocator, Policy>
+
+TEMPLATE
+BUFFERED_ORDERED_SET::buffered_ordered_set(size_t max_pending, const Compare &comp, const Allocator &alloc)
+    : set_(comp, alloc), inserted_(comp, change_allocator(alloc)), erased_(comp, change_allocator(alloc)), max_pending_(max_pending), comp_(comp) {}
+
+
+// Getting
+
+TEMPLATE
+typename BUFFERED_ORDERED_SET::size_type BUFFERED_ORDERED_SET::size() const {
+    resolve();
+    return set_.size() + inserted_.size() - erased_.size();
+}
+
+TEMPLATE
+bool BUFFERED_ORDERED_SET::empty() const { return size() == 0; }
+
+// The number of writes and resolved changes not merged into the tree yet.
+TEMPLATE
+size_t BUFFERED_ORDERED_SET::pending() const { return log_.size() + inserted_.size() + erased_.size(); }
+
+// The set with everything merged, for any query the wrapper doesn't answer itself.
+TEMPLATE
+const typename BUFFERED_ORDERED_SET::set_type &BUFFERED_ORDERED_SET::keys() const {
+    flush();
+    return set_;
+}
+
+TEMPLATE
+bool BUFFERED_ORDERED_SET::contains(const T &key) const {
+    resolve();
+    if (inserted_.contains(key)) return true;
+    return !erased_.contains(key) && set_.find(key) != set_.end();
+}
+
+// Returns the smallest element not less than key, if any: the element at key's order.
+TEMPLATE
+optional<T> BUFFERED_ORDERED_SET::lower_bound(const T &key) const { return find_by_order(order_of_key(key)); }
+
+// Returns the k-th smallest element, or nullopt if there are at most k elements.
+// The inserted keys before it, and then the erased ones before it, are found by binary searches over the changes' ranks in the tree,
+// so it takes O(log^2 p) steps over p changes and at most one descent of the tree.
+TEMPLATE
+optional<T> BUFFERED_ORDERED_SET::find_by_order(size_type k) const {
+    resolve();
+    // The number of elements less than the i-th inserted key, which grows with i.
+    auto inserted_before = [&](size_type i) {
+        auto entry = inserted_.find_by_order(i);
+        return entry->second - erased_.order_of_key(entry->first) + i;
+    };
+    size_type lo = 0, hi = inserted_.size();
+    while (lo < hi) {
+        size_type mid = lo + (hi - lo) / 2;
+        if (inserted_before(mid) <= k) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo && inserted_before(lo - 1) == k) return inserted_.find_by_order(lo - 1)->first;
+    
+    // Otherwise it's the tree element with k - lo kept tree elements before it. The i-th erased key has its rank minus i of them before it.
+    size_type kept = k - lo;
+    lo = 0, hi = erased_.size();
+    while (lo < hi) {
+        size_type mid = lo + (hi - lo) / 2;
+        if (erased_.find_by_order(mid)->second - mid <= kept) lo = mid + 1;
+        else hi = mid;
+    }
+    size_type order = kept + lo;
+    if (order >= set_.size()) return nullopt;
+    return *set_.find_by_order(order);
+}
+
+// The tree's rank of key, plus the inserted and minus the erased keys less than key.
+TEMPLATE
+typename BUFFERED_ORDERED_SET::size_type BUFFERED_ORDERED_SET::order_of_key(const T &key) const {
+    resolve();
+    return set_.order_of_key(key) + inserted_.order_of_key(key) - erased_.order_of_key(key);
+}
+
+
+// Updating
+
+// Inserts key, if it isn't there by the time the log is resolved. Returns nothing, as that's only known then.
+TEMPLATE
+void BUFFERED_ORDERED_SET::insert(const T &key) { write(key, false); }
+
+TEMPLATE
+void BUFFERED_ORDERED_SET::insert(T &&key) { write(std::move(key), false); }
+
+// Erases key, if it's there by the time the log is resolved.
+TEMPLATE
+void BUFFERED_ORDERED_SET::erase(const T &key) { write(key, true); }
+
+TEMPLATE
+template<typename K>
+void BUFFERED_ORDERED_SET::write(K &&key, bool erase) {
+    log_.push_back({std::forward<K>(key), erase});
+    if (pending() >= max(max_pending_, size_t(set_.size()))) flush();
+}
+
+// Merges the changes and the log into the tree: the erased keys are erased and the inserted ones inserted, both as sorted ranges.
+// Iterators into keys() stay valid unless their element is erased, as the tree keeps its nodes when it rebuilds, and subtract moves only the other set's.
+TEMPLATE
+void BUFFERED_ORDERED_SET::flush() const {
+    if (pending() == 0) return;
+    // The changes come before the log, so that the log's writes win.
+    vector<Write> writes;
+    writes.reserve(pending());
+    erased_.for_each([&](const auto &entry) { writes.push_back({entry.first, true}); });
+    inserted_.for_each([&](const auto &entry) { writes.push_back({entry.first, false}); });
+    for (Write &write: log_) writes.push_back(std::move(write));
+    erased_.clear();
+    inserted_.clear();
+    log_.clear();
+    
+    vector<T> inserted, erased;
+    for (Write &write: latest_writes(writes, comp_)) (write.erase ? erased : inserted).push_back(std::move(write.key));
+    if (erased.size() * BULK_RATIO < set_.size()) {
+        for (const T &key: erased) set_.erase(key);
+    } else {
+        set_type keys(comp_);
+        keys.insert(make_move_iterator(erased.begin()), make_move_iterator(erased.end()));
+        set_.subtract(std::move(keys));
+    }
+    set_.insert(make_move_iterator(inserted.begin()), make_move_iterator(inserted.end()));
+}
+
+// Sorts the log and folds it into the changes. The keys' ranks in the tree, and whether they're in it, come from one batch of interleaved descents.
+// A write replaces any change of its key, and leaves none if it puts the key back the way the tree has it.
+TEMPLATE
+void BUFFERED_ORDERED_SET::resolve() const {
+    if (log_.empty()) return;
+    vector<Write> writes = latest_writes(log_, comp_);
+    log_.clear();
+    size_t n = writes.size();
+    vector<T> keys;
+    keys.reserve(n);
+    for (const Write &write: writes) keys.push_back(write.key);
+    vector<size_type> ranks(n);
+    auto found = make_unique<bool[]>(n);
+    set_.order_of_keys(keys, ranks, span(found.get(), n));
+    
+    // Only keys in the tree can have been erased, and only keys missing from it inserted, so each write touches one of the two.
+    for (size_t i = 0; i < n; i++) {
+        change_map &changes = found[i] ? erased_ : inserted_;
+        if (writes[i].erase == found[i]) changes.try_emplace(keys[i], ranks[i]);
+        else changes.erase(keys[i]);
+    }
+    if ((inserted_.size() + erased_.size()) * CHANGE_RATIO >= max(max_pending_, size_t(set_.size()))) flush();
+}
+
+// Sorts writes by key, keeping their order among equal keys, and returns the last write of each key.
+TEMPLATE
+vector<typename BUFFERED_ORDERED_SET::Write> BUFFERED_ORDERED_SET::latest_writes(vector<Write> &writes, const Compare &comp) {
+    stable_sort(writes.begin(), writes.end(), [&](const Write &a, const Write &b) { return comp(a.key, b.key); });
+    vector<Write> latest;
+    for (size_t i = 0; i < writes.size(); i++) {
+        if (i + 1 < writes.size() && !comp(writes[i].key, writes[i + 1].key)) continue;
+        latest.push_back(std::move(writes[i]));
+    }
+    return latest;
+}
+
+#undef BUFFERED_ORDERED_SET
+#undef TEMPLATE
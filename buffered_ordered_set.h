@@ -0,0 +1,83 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#ifndef ORDERED_SET_BUFFERED_ORDERED_SET_H
+#define ORDERED_SET_BUFFERED_ORDERED_SET_H
+
+#include "ordered_map.h"
+
+// An ordered_set that absorbs bursts of writes: insert and erase append to an unsorted log instead of descending the tree.
+// A read first resolves the log into changes, the keys missing from the tree that are inserted and the keys in the tree that are erased, each kept
+// in a small ordered_map along with its rank in the tree, and answers from the tree and the changes together without merging them.
+// The log is merged into the tree in one go once it holds as many writes as the set has elements (and at least max_pending),
+// and the changes once they number a CHANGE_RATIO-th of that.
+// Large merges rebuild the tree in one linear pass (see ordered_set::insert(first, last)), so a burst of inserts costs little more than sorting it.
+// Reads return copies of elements, as pending ones have no node yet. They are const but may resolve or merge, so the set can't be read from several threads at once.
+template<typename T, typename Compare = less<T>, typename Allocator = allocator<T>, typename Policy = tree_policy>
+class buffered_ordered_set {
+    static_assert(!Policy::multi, "Only the last write of each key is merged, which needs keys to be unique.");
+
+public:
+    using set_type = ordered_set<T, Compare, Allocator, Policy>;
+    using size_type = typename set_type::size_type;
+    
+    explicit buffered_ordered_set(size_t max_pending = DEFAULT_MAX_PENDING, const Compare &comp = Compare(), const Allocator &alloc = Allocator());
+    
+    [[nodiscard]] size_type size() const;
+    
+    [[nodiscard]] bool empty() const;
+    
+    [[nodiscard]] size_t pending() const;
+    
+    [[nodiscard]] const set_type &keys() const;
+    
+    bool contains(const T &key) const;
+    
+    optional<T> lower_bound(const T &key) const;
+    
+    optional<T> find_by_order(size_type k) const;
+    
+    size_type order_of_key(const T &key) const;
+    
+    void insert(const T &key);
+    
+    void insert(T &&key);
+    
+    void erase(const T &key);
+    
+    void flush() const;
+
+private:
+    struct Write {
+        T key;
+        bool erase;
+    };
+    
+    using change_allocator = typename allocator_traits<Allocator>::template rebind_alloc<map_entry<T, size_type>>;
+    using change_map = ordered_map<T, size_type, Compare, change_allocator>;
+    
+    static constexpr size_t DEFAULT_MAX_PENDING = 1 << 12;
+    
+    // The changes are merged once they number size() / CHANGE_RATIO, as reads and resolving cost more the larger their maps grow.
+    static constexpr size_t CHANGE_RATIO = 8;
+    
+    // Erases of at least size() / BULK_RATIO keys are merged by subtracting a set of them instead of erasing one by one.
+    static constexpr size_t BULK_RATIO = 8;
+    
+    // Resolving and merging change how the contents are stored but not what they are, so const reads can do either.
+    mutable set_type set_;
+    mutable vector<Write> log_;
+    mutable change_map inserted_, erased_;
+    size_t max_pending_;
+    [[no_unique_address]] Compare comp_;
+    
+    template<typename K>
+    void write(K &&key, bool erase);
+    
+    void resolve() const;
+    
+    static vector<Write> latest_writes(vector<Write> &writes, const Compare &comp);
+};
+
+#endif //ORDERED_SET_BUFFERED_ORDERED_SET_H
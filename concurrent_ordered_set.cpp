@@ -0,0 +1,125 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#include "concurrent_ordered_set.h"
+#include "ordered_set.cpp"
+
+#define TEMPLATE template<typename T, typename Compare, typename Allocator, typename Policy>
+#define CONCURRENT_ORDERED_SET concurrent_ordered_set<T, Compare, Allocator, Policy>
+
+
+// Getting
+
+TEMPLATE
+typename CONCURRENT_ORDERED_SET::size_type CONCURRENT_ORDERED_SET::size() const { return read([](const set_type &set) { return set.size(); }); }
+
+TEMPLATE
+bool CONCURRENT_ORDERED_SET::empty() const { return size() == 0; }
+
+TEMPLATE
+bool CONCURRENT_ORDERED_SET::contains(const T &key) const {
+    return read([&](const set_type &set) { return set.find(key) != set.end(); });
+}
+
+// Returns the smallest element not less than key, if any.
+TEMPLATE
+optional<T> CONCURRENT_ORDERED_SET::lower_bound(const T &key) const {
+    return read([&](const set_type &set) -> optional<T> {
+        auto it = set.lower_bound(key);
+        if (it == set.end()) return nullopt;
+        return *it;
+    });
+}
+
+// Returns the k-th smallest element, or nullopt if there are at most k elements.
+TEMPLATE
+optional<T> CONCURRENT_ORDERED_SET::find_by_order(size_type k) const {
+    return read([&](const set_type &set) -> optional<T> {
+        if (k >= set.size()) return nullopt;
+        return *set.find_by_order(k);
+    });
+}
+
+TEMPLATE
+typename CONCURRENT_ORDERED_SET::size_type CONCURRENT_ORDERED_SET::order_of_key(const T &key) const {
+    return read([&](const set_type &set) { return set.order_of_key(key); });
+}
+
+// Runs f on a consistent state of the set and returns its result, so several queries can see the same version.
+// f must not let iterators or references into the set escape, and a long f holds up the next writer.
+TEMPLATE
+template<typename F>
+auto CONCURRENT_ORDERED_SET::read(F &&f) const {
+    read_indicator &readers = readers_[epoch_.load()];
+    readers.arrive();
+    struct Departure {
+        read_indicator &readers;
+        
+        ~Departure() { readers.depart(); }
+    } departure{readers};
+    return f(sets_[front_.load()]);
+}
+
+
+// Updating
+
+TEMPLATE
+bool CONCURRENT_ORDERED_SET::insert(const T &key) {
+    bool inserted;
+    write([&](set_type &set) { inserted = set.insert(key).second; });
+    return inserted;
+}
+
+TEMPLATE
+bool CONCURRENT_ORDERED_SET::erase(const T &key) {
+    bool erased;
+    write([&](set_type &set) { erased = set.erase(key); });
+    return erased;
+}
+
+// Applies f to both copies of the set, one after the other, so f must do the same to both.
+TEMPLATE
+template<typename F>
+void CONCURRENT_ORDERED_SET::write(F &&f) {
+    lock_guard lock(writer_);
+    int front = front_.load();
+    f(sets_[!front]);
+    front_.store(!front);
+    wait_for_readers();
+    f(sets_[front]);
+}
+
+// Waits until no reader can still be on the copy that was in front before the last flip.
+// Arriving readers are moved to the other indicator first, so neither wait can be starved by new readers.
+TEMPLATE
+void CONCURRENT_ORDERED_SET::wait_for_readers() {
+    int epoch = epoch_.load();
+    while (!readers_[!epoch].empty()) this_thread::yield();
+    epoch_.store(!epoch);
+    while (!readers_[epoch].empty()) this_thread::yield();
+}
+
+
+// Read Indicator
+
+TEMPLATE
+void CONCURRENT_ORDERED_SET::read_indicator::arrive() { stripes_[stripe()].readers.fetch_add(1); }
+
+TEMPLATE
+void CONCURRENT_ORDERED_SET::read_indicator::depart() { stripes_[stripe()].readers.fetch_sub(1); }
+
+TEMPLATE
+bool CONCURRENT_ORDERED_SET::read_indicator::empty() const {
+    for (const Stripe &stripe: stripes_) if (stripe.readers.load()) return false;
+    return true;
+}
+
+TEMPLATE
+size_t CONCURRENT_ORDERED_SET::read_indicator::stripe() {
+    static thread_local size_t stripe = hash<thread::id>()(this_thread::get_id()) % STRIPES;
+    return stripe;
+}
+
+#undef CONCURRENT_ORDERED_SET
+#undef TEMPLATE
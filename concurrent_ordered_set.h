@@ -0,0 +1,79 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#ifndef ORDERED_SET_CONCURRENT_ORDERED_SET_H
+#define ORDERED_SET_CONCURRENT_ORDERED_SET_H
+
+#include "ordered_set.h"
+
+// An ordered_set any number of threads can read while others write, readers never block or retry.
+// Keeps two copies of the set (the Left-Right technique): readers announce themselves and read the published copy,
+// a writer updates the other copy, publishes it, waits for the readers still on the old one to leave and replays the update there.
+// Reads are linearizable and wait-free, writes are serialized and pay twice plus the longest read in flight, memory is doubled.
+template<typename T, typename Compare = less<T>, typename Allocator = allocator<T>, typename Policy = tree_policy>
+class concurrent_ordered_set {
+public:
+    using set_type = ordered_set<T, Compare, Allocator, Policy>;
+    using size_type = typename set_type::size_type;
+    
+    concurrent_ordered_set() = default;
+    
+    concurrent_ordered_set(const concurrent_ordered_set &) = delete;
+    
+    concurrent_ordered_set &operator=(const concurrent_ordered_set &) = delete;
+    
+    [[nodiscard]] size_type size() const;
+    
+    [[nodiscard]] bool empty() const;
+    
+    [[nodiscard]] bool contains(const T &key) const;
+    
+    [[nodiscard]] optional<T> lower_bound(const T &key) const;
+    
+    [[nodiscard]] optional<T> find_by_order(size_type k) const;
+    
+    [[nodiscard]] size_type order_of_key(const T &key) const;
+    
+    template<typename F>
+    auto read(F &&f) const;
+    
+    bool insert(const T &key);
+    
+    bool erase(const T &key);
+    
+    template<typename F>
+    void write(F &&f);
+
+private:
+    // Counts the readers inside, striped over cache lines so that readers on different threads don't contend.
+    class read_indicator {
+    public:
+        void arrive();
+        
+        void depart();
+        
+        [[nodiscard]] bool empty() const;
+
+    private:
+        static constexpr size_t STRIPES = 16;
+        
+        struct alignas(64) Stripe {
+            atomic<long> readers{0};
+        };
+        
+        Stripe stripes_[STRIPES];
+        
+        static size_t stripe();
+    };
+    
+    set_type sets_[2];
+    atomic<int> front_{0}; // The copy readers are sent to.
+    atomic<int> epoch_{0}; // The indicator arriving readers register with.
+    mutable read_indicator readers_[2];
+    mutex writer_;
+    
+    void wait_for_readers();
+};
+
+#endif //ORDERED_SET_CONCURRENT_ORDERED_SET_H
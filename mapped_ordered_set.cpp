@@ -0,0 +1,134 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#include "mapped_ordered_set.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEMPLATE template<typename T, typename Compare>
+#define MAPPED_ORDERED_SET mapped_ordered_set<T, Compare>
+#define iterator typename MAPPED_ORDERED_SET::Iterator
+
+
+// Maps the file at path read-only and checks its header, throwing runtime_error if it can't be mapped or isn't a save of this element type.
+TEMPLATE
+MAPPED_ORDERED_SET::mapped_ordered_set(const string &path, const Compare &comp) : comp_(comp) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("Can't open " + path + ".");
+    struct stat status{};
+    if (fstat(fd, &status) < 0 || size_t(status.st_size) < sizeof(ordered_set_file_header)) {
+        close(fd);
+        throw runtime_error("Not an ordered_set file.");
+    }
+    bytes_ = size_t(status.st_size);
+    map_ = mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        throw runtime_error("Can't map " + path + ".");
+    }
+    
+    try {
+        header().check(sizeof(T));
+        if (header().size > (bytes_ - sizeof(ordered_set_file_header)) / sizeof(T)) throw runtime_error("Truncated ordered_set file.");
+    } catch (...) {
+        unmap();
+        throw;
+    }
+    elements_ = reinterpret_cast<const T *>(static_cast<const char *>(map_) + sizeof(ordered_set_file_header));
+    size_ = size_type(header().size);
+}
+
+TEMPLATE
+MAPPED_ORDERED_SET::mapped_ordered_set(mapped_ordered_set &&other) noexcept
+        : map_(exchange(other.map_, nullptr)), bytes_(exchange(other.bytes_, 0)), elements_(exchange(other.elements_, nullptr)),
+          size_(exchange(other.size_, 0)), comp_(std::move(other.comp_)) {}
+
+TEMPLATE
+MAPPED_ORDERED_SET &MAPPED_ORDERED_SET::operator=(mapped_ordered_set &&other) noexcept {
+    if (this != &other) {
+        unmap();
+        map_ = exchange(other.map_, nullptr);
+        bytes_ = exchange(other.bytes_, 0);
+        elements_ = exchange(other.elements_, nullptr);
+        size_ = exchange(other.size_, 0);
+        comp_ = std::move(other.comp_);
+    }
+    return *this;
+}
+
+TEMPLATE
+MAPPED_ORDERED_SET::~mapped_ordered_set() { unmap(); }
+
+
+// Properties
+
+TEMPLATE
+typename MAPPED_ORDERED_SET::size_type MAPPED_ORDERED_SET::size() const { return size_; }
+
+TEMPLATE
+bool MAPPED_ORDERED_SET::empty() const { return !size_; }
+
+// Reads the whole file to check it against the checksum in its header.
+TEMPLATE
+bool MAPPED_ORDERED_SET::verify() const {
+    checksum64 checksum;
+    checksum.update(elements_, size_ * sizeof(T));
+    return checksum.value() == header().checksum;
+}
+
+
+// Getting
+
+TEMPLATE
+const T &MAPPED_ORDERED_SET::operator[](size_type index) const { return *find_by_order(index); }
+
+TEMPLATE
+iterator MAPPED_ORDERED_SET::begin() const { return elements_; }
+
+TEMPLATE
+iterator MAPPED_ORDERED_SET::end() const { return elements_ + size_; }
+
+// Returns a pointer to the element equal to key, or end() if there is none.
+TEMPLATE
+iterator MAPPED_ORDERED_SET::find(const T &key) const {
+    Iterator it = lower_bound(key);
+    return it != end() && !comp_(key, *it) ? it : end();
+}
+
+TEMPLATE
+iterator MAPPED_ORDERED_SET::lower_bound(const T &key) const { return std::lower_bound(begin(), end(), key, comp_); }
+
+TEMPLATE
+iterator MAPPED_ORDERED_SET::upper_bound(const T &key) const { return std::upper_bound(begin(), end(), key, comp_); }
+
+// Returns a pointer to the (k+1)-th least element, or end() if k == size().
+TEMPLATE
+iterator MAPPED_ORDERED_SET::find_by_order(size_type k) const {
+    if (k > size_) throw out_of_range("Order out of range.");
+    return elements_ + k;
+}
+
+TEMPLATE
+typename MAPPED_ORDERED_SET::size_type MAPPED_ORDERED_SET::order_of_key(const T &key) const { return size_type(lower_bound(key) - begin()); }
+
+
+// Mapping
+
+TEMPLATE
+const ordered_set_file_header &MAPPED_ORDERED_SET::header() const { return *static_cast<const ordered_set_file_header *>(map_); }
+
+TEMPLATE
+void MAPPED_ORDERED_SET::unmap() {
+    if (map_) munmap(map_, bytes_);
+    map_ = nullptr;
+    elements_ = nullptr;
+    size_ = 0;
+}
+
+#undef iterator
+#undef MAPPED_ORDERED_SET
+#undef TEMPLATE
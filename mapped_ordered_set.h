@@ -0,0 +1,64 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#ifndef ORDERED_SET_MAPPED_ORDERED_SET_H
+#define ORDERED_SET_MAPPED_ORDERED_SET_H
+
+#include "ordered_set.h"
+
+// A read-only view of a file written by ordered_set::save, memory-mapped and searched in place: opening one costs a few system calls whatever the size,
+// and pages are only read in as lookups touch them. Lookups binary search the sorted elements, find_by_order indexes them, and iterators are plain pointers into the mapping.
+// The checksum is only verified on demand (verify()), as that reads the whole file.
+template<typename T, typename Compare = less<T>>
+class mapped_ordered_set {
+    static_assert(is_trivially_copyable_v<T>, "Mapped elements must be trivially copyable.");
+    static_assert(alignof(T) <= sizeof(ordered_set_file_header), "Mapped elements would be misaligned.");
+
+public:
+    using Iterator = const T *;
+    using size_type = size_t;
+    
+    explicit mapped_ordered_set(const string &path, const Compare &comp = Compare());
+    
+    mapped_ordered_set(mapped_ordered_set &&other) noexcept;
+    
+    mapped_ordered_set &operator=(mapped_ordered_set &&other) noexcept;
+    
+    ~mapped_ordered_set();
+    
+    [[nodiscard]] size_type size() const;
+    
+    [[nodiscard]] bool empty() const;
+    
+    [[nodiscard]] bool verify() const;
+    
+    const T &operator[](size_type index) const;
+    
+    Iterator begin() const;
+    
+    Iterator end() const;
+    
+    Iterator find(const T &key) const;
+    
+    Iterator lower_bound(const T &key) const;
+    
+    Iterator upper_bound(const T &key) const;
+    
+    Iterator find_by_order(size_type k) const;
+    
+    size_type order_of_key(const T &key) const;
+
+private:
+    void *map_ = nullptr;
+    size_t bytes_ = 0;
+    const T *elements_ = nullptr;
+    size_type size_ = 0;
+    [[no_unique_address]] Compare comp_;
+    
+    const ordered_set_file_header &header() const;
+    
+    void unmap();
+};
+
+#endif //ORDERED_SET_MAPPED_ORDERED_SET_H
@@ -0,0 +1,73 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#include "ordered_map.h"
+#include "ordered_set.cpp"
+
+#define TEMPLATE template<typename K, typename V, typename Compare, typename Allocator, typename Policy>
+#define ORDERED_MAP ordered_map<K, V, Compare, Allocator, Policy>
+#define iterator typename ORDERED_MAP::Iterator
+
+
+TEMPLATE
+ORDERED_MAP::ordered_map(const Compare &comp, const Allocator &alloc) : set_type(entry_compare<Compare>{comp}, alloc) {}
+
+TEMPLATE
+ORDERED_MAP::ordered_map(set_type &&entries) : set_type(std::move(entries)) {}
+
+
+// Getting
+
+// Returns the value mapped to key, inserting a default constructed one if key is missing.
+TEMPLATE
+V &ORDERED_MAP::operator[](const K &key) { return try_emplace(key).first->second; }
+
+// Returns the value mapped to key, throwing out_of_range if key is missing.
+TEMPLATE
+V &ORDERED_MAP::at(const K &key) {
+    Iterator it = this->find(key);
+    if (it == this->end()) throw out_of_range("Key not found.");
+    return it->second;
+}
+
+TEMPLATE
+const V &ORDERED_MAP::at(const K &key) const { return const_cast<ordered_map *>(this)->at(key); }
+
+TEMPLATE
+bool ORDERED_MAP::contains(const K &key) const { return this->find(key) != this->end(); }
+
+
+// Updating
+
+// Inserts an entry for key with the value constructed from args, unless key is already there, in which case args are left untouched.
+// It takes a single descent, which finds where the entry goes before building it, and so do operator[] and insert_or_assign.
+TEMPLATE
+template<typename... Args>
+pair<iterator, bool> ORDERED_MAP::try_emplace(const K &key, Args &&... args) {
+    return this->insert_missing(key, [&] { return map_entry<K, V>{key, V(std::forward<Args>(args)...)}; });
+}
+
+// Maps key to value, overwriting the value already there if any. Returns whether a new entry was inserted.
+TEMPLATE
+template<typename M>
+pair<iterator, bool> ORDERED_MAP::insert_or_assign(const K &key, M &&value) {
+    auto [it, inserted] = this->insert_missing(key, [&] { return map_entry<K, V>{key, V(std::forward<M>(value))}; });
+    if (!inserted) it->second = std::forward<M>(value);
+    return {it, inserted};
+}
+
+
+// Splitting
+
+// Moves the entries whose key is not less than key out into the returned map in O(log(n)), like ordered_set::split.
+TEMPLATE
+ORDERED_MAP ORDERED_MAP::split(const K &key) { return split_by_order(this->order_of_key(key)); }
+
+// Keeps the k entries with the smallest keys and moves the rest out into the returned map in O(log(n)).
+TEMPLATE
+ORDERED_MAP ORDERED_MAP::split_by_order(size_type k) { return ordered_map(set_type::split_by_order(k)); }
+
+#undef iterator
+#undef ORDERED_MAP
+#undef TEMPLATE
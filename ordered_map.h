@@ -0,0 +1,75 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#ifndef ORDERED_SET_ORDERED_MAP_H
+#define ORDERED_SET_ORDERED_MAP_H
+
+#include "ordered_set.h"
+
+// An element of ordered_map. Iterators only give const access, which keeps the key fixed, while the mapped value stays writable.
+template<typename K, typename V>
+struct map_entry {
+    K first;
+    mutable V second;
+};
+
+// Orders map entries by key with Compare, and compares entries with bare keys so that lookups need no entry.
+template<typename Compare>
+struct entry_compare {
+    using is_transparent = void;
+    
+    [[no_unique_address]] Compare comp;
+    
+    template<typename A, typename B>
+    bool operator()(const A &a, const B &b) const { return comp(key_of(a), key_of(b)); }
+
+private:
+    template<typename K, typename V>
+    static const K &key_of(const map_entry<K, V> &entry) { return entry.first; }
+    
+    template<typename K>
+    static const K &key_of(const K &key) { return key; }
+};
+
+// An ordered_set of (key, value) entries, looked up by key. The value lives in the entry's node, so a lookup by key or order reaches it in one descent.
+// find, lower_bound, upper_bound, order_of_key, count and erase take keys, find_by_order returns an iterator to the entry.
+// operator[] takes a key as in std::map (use find_by_order for the k-th entry).
+template<typename K, typename V, typename Compare = less<K>, typename Allocator = allocator<map_entry<K, V>>, typename Policy = tree_policy>
+class ordered_map : public ordered_set<map_entry<K, V>, entry_compare<Compare>, Allocator, Policy> {
+private:
+    using set_type = ordered_set<map_entry<K, V>, entry_compare<Compare>, Allocator, Policy>;
+
+public:
+    using Iterator = typename set_type::Iterator;
+    using size_type = typename set_type::size_type;
+    
+    using set_type::set_type;
+    
+    ordered_map() = default;
+    
+    explicit ordered_map(const Compare &comp, const Allocator &alloc = Allocator());
+    
+    V &operator[](const K &key);
+    
+    V &at(const K &key);
+    
+    const V &at(const K &key) const;
+    
+    bool contains(const K &key) const;
+    
+    template<typename... Args>
+    pair<Iterator, bool> try_emplace(const K &key, Args &&... args);
+    
+    template<typename M>
+    pair<Iterator, bool> insert_or_assign(const K &key, M &&value);
+    
+    ordered_map split(const K &key);
+    
+    ordered_map split_by_order(size_type k);
+
+private:
+    explicit ordered_map(set_type &&entries);
+};
+
+#endif //ORDERED_SET_ORDERED_MAP_H
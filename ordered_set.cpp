@@ -2,378 +2,1924 @@
 // Created by Eddard on 2023-03-05.
 //
 
+#ifndef ORDERED_SET_ORDERED_SET_CPP
+#define ORDERED_SET_ORDERED_SET_CPP
+
 #include "ordered_set.h"
 
-#define iterator typename ordered_set<T>::Iterator
+#define TEMPLATE template<typename T, typename Compare, typename Allocator, typename Policy>
+#define ORDERED_SET ordered_set<T, Compare, Allocator, Policy>
+#define iterator typename ORDERED_SET::Iterator
+
+
+TEMPLATE
+ORDERED_SET::ordered_set(const Allocator &alloc) : pool_(make_shared<pool_type>(alloc)) {}
+
+TEMPLATE
+ORDERED_SET::ordered_set(const Compare &comp, const Allocator &alloc) : pool_(make_shared<pool_type>(alloc)), comp_(comp) {}
+
+TEMPLATE
+ORDERED_SET::ordered_set(shared_ptr<pool_type> pool, link root, const Compare &comp) : root_(root), pool_(std::move(pool)), comp_(comp) {}
+
+TEMPLATE
+ORDERED_SET::ordered_set(initializer_list<T> values) { insert(values.begin(), values.end()); }
+
+TEMPLATE
+template<typename InputIt>
+ORDERED_SET::ordered_set(InputIt first, InputIt last) { insert(first, last); }
 
+TEMPLATE
+ORDERED_SET::ordered_set(ordered_set &&other) noexcept : root_(exchange(other.root_, link())), pool_(std::move(other.pool_)), comp_(std::move(other.comp_)) {}
 
-template<typename T>
-ordered_set<T>::ordered_set(initializer_list<T> values) { for (T value: values) insert(value); }
+TEMPLATE
+ORDERED_SET &ORDERED_SET::operator=(ordered_set &&other) noexcept {
+    if (this != &other) {
+        clear();
+        root_ = exchange(other.root_, link());
+        pool_ = std::move(other.pool_);
+        comp_ = std::move(other.comp_);
+    }
+    return *this;
+}
+
+TEMPLATE
+ORDERED_SET::~ordered_set() { clear(); }
 
 
 // Tree Properties
 
-template<typename T>
-int ordered_set<T>::size() const { return root_ ? root_->size_ : 0; }
+TEMPLATE
+typename ORDERED_SET::size_type ORDERED_SET::size() const { return subtree_size(root_); }
 
-template<typename T>
-bool ordered_set<T>::empty() const { return !size(); }
+// The most elements the set can hold: the size field of a node is one bit short of size_type, and compact_layout indices run out a little before 2^32.
+TEMPLATE
+typename ORDERED_SET::size_type ORDERED_SET::max_size() const {
+    size_t max = numeric_limits<size_type>::max() >> 1;
+    return size_type(min<size_t>(max, pool_type::max_nodes()));
+}
+
+TEMPLATE
+bool ORDERED_SET::empty() const { return !size(); }
 
-template<typename T>
-void ordered_set<T>::clear() { root_.reset(); }
+// Bytes held by the set, counting the unused slots of the node pool (which sets split off each other share).
+TEMPLATE
+size_t ORDERED_SET::memory_usage() const { return sizeof(*this) + (pool_ ? pool_->memory_usage() : 0); }
+
+// Returns what the set has counted so far. Safe to call while other threads read the set.
+TEMPLATE
+ordered_set_stats ORDERED_SET::stats() const requires STATS {
+    ordered_set_stats snapshot;
+    for (auto [name, counter]: ordered_set_stats::counters()) snapshot.*counter = atomic_ref(stats_.*counter).load(memory_order_relaxed);
+    return snapshot;
+}
+
+TEMPLATE
+void ORDERED_SET::reset_stats() requires STATS { stats_ = {}; }
+
+// Checks every invariant of the tree in O(n): links between parents and children, order, red-black colors, sizes and aggregates (when they can be compared).
+// Throws logic_error naming the first broken one, otherwise returns the tree's black height and how many nodes are at each depth.
+TEMPLATE
+ordered_set_shape ORDERED_SET::validate() const {
+    ordered_set_shape shape;
+    if (color(root_) != BLACK) throw logic_error("Red root.");
+    if (root_ && node(root_).parent_) throw logic_error("Root with a parent.");
+    link prev = {};
+    shape.black_height = validate(root_, 0, prev, shape);
+    return shape;
+}
+
+// When the set owns its pool alone, trivially destructible nodes are dropped along with the slabs, otherwise they are freed in a single pass over the tree.
+TEMPLATE
+void ORDERED_SET::clear() {
+    if (pool_.use_count() > 1 || !is_trivially_destructible_v<Node>) free_subtree(root_);
+    root_ = {};
+    if (pool_.use_count() == 1) pool_->release();
+}
+
+TEMPLATE
+template<typename InputIt>
+void ORDERED_SET::assign(InputIt first, InputIt last) {
+    clear();
+    insert(first, last);
+}
 
 
 // Getting
 
-template<typename T>
-const T &ordered_set<T>::operator[](int index) { return *find_by_order(index); }
+TEMPLATE
+const T &ORDERED_SET::operator[](size_type index) { return *find_by_order(index); }
 
 // Returns an iterator to the smallest element.
-template<typename T>
-iterator ordered_set<T>::begin() const { return find_by_order(0); }
+TEMPLATE
+iterator ORDERED_SET::begin() const { return find_by_order(0); }
 
 // Returns past-the-end (end()) iterator.
-template<typename T>
-iterator ordered_set<T>::end() const { return Iterator(this); }
+TEMPLATE
+iterator ORDERED_SET::end() const { return Iterator(this); }
 
 // Returns an iterator to the element equal to key, or end() iterator if no such element exists in the set.
-template<typename T>
-iterator ordered_set<T>::find(T key) const {
-    Node *u = root_.get();
-    while (u) {
-        if (key == u->value_) break;
-        if (key < u->value_) u = u->child_[LEFT].get();
-        else u = u->child_[RIGHT].get();
-    }
-    return Iterator(this, u);
+// With a transparent Compare, key may be of any type it compares with T (a string_view for string elements, say), so nothing is converted.
+TEMPLATE
+iterator ORDERED_SET::find(const T &key) const {
+    tally(&ordered_set_stats::lookups);
+    return Iterator(this, locate(key));
+}
+
+TEMPLATE
+template<typename K>
+iterator ORDERED_SET::find(const K &key) const requires TRANSPARENT {
+    tally(&ordered_set_stats::lookups);
+    return Iterator(this, locate(key));
 }
 
 // Returns an iterator to the least element greater than or equal to key, or end() iterator if no such element exists in the set.
-template<typename T>
-iterator ordered_set<T>::lower_bound(T key) const {
-    Node *u = root_.get();
-    Node *ret = nullptr;
-    while (u) {
-        if (key <= u->value_) ret = u, u = u->child_[LEFT].get();
-        else u = u->child_[RIGHT].get();
-    }
-    return Iterator(this, ret);
+TEMPLATE
+iterator ORDERED_SET::lower_bound(const T &key) const {
+    tally(&ordered_set_stats::lookups);
+    return Iterator(this, bound(key, false));
+}
+
+TEMPLATE
+template<typename K>
+iterator ORDERED_SET::lower_bound(const K &key) const requires TRANSPARENT {
+    tally(&ordered_set_stats::lookups);
+    return Iterator(this, bound(key, false));
 }
 
 // Returns an iterator to the least element greater than key, or end() iterator if no such element exists in the set.
-template<typename T>
-iterator ordered_set<T>::upper_bound(T key) const {
-    Node *u = root_.get();
-    Node *ret = nullptr;
-    while (u) {
-        if (key < u->value_) ret = u, u = u->child_[LEFT].get();
-        else u = u->child_[RIGHT].get();
-    }
-    return Iterator(this, ret);
+TEMPLATE
+iterator ORDERED_SET::upper_bound(const T &key) const {
+    tally(&ordered_set_stats::lookups);
+    return Iterator(this, bound(key, true));
+}
+
+TEMPLATE
+template<typename K>
+iterator ORDERED_SET::upper_bound(const K &key) const requires TRANSPARENT {
+    tally(&ordered_set_stats::lookups);
+    return Iterator(this, bound(key, true));
 }
 
 // Returns an iterator to the (k+1)-th least element, or end() iterator if the size of the set is less than k+1.
-template<typename T>
-iterator ordered_set<T>::find_by_order(int k) const {
-    if (!root_ || k == root_->size_) return end();
+TEMPLATE
+iterator ORDERED_SET::find_by_order(size_type k) const {
+    tally(&ordered_set_stats::select_queries);
+    if (!root_ || k == size()) return end();
     
-    if (k < 0 || k > root_->size_) throw out_of_range("Order out of range.");
+    // A negative order converted to size_type lands far above size().
+    if (k > size()) throw out_of_range("Order out of range.");
     
-    Node *u = root_.get();
-    while (true) {
-        int l_size = u->child_[LEFT] ? u->child_[LEFT]->size_ : 0;
-        if (l_size == k) return Iterator(this, u);
+    link u = root_;
+    for (int depth = 1;; depth++) {
+        size_type l_size = subtree_size(node(u).child_[LEFT]);
+        if (l_size == k) {
+            tally_descent(depth);
+            return Iterator(this, u);
+        }
         if (l_size > k) {
-            u = u->child_[LEFT].get();
+            u = node(u).child_[LEFT];
         } else {
             k -= l_size + 1;
-            u = u->child_[RIGHT].get();
+            u = node(u).child_[RIGHT];
         }
     }
     
 }
 
 // Returns the number of elements in the set strictly less than key.
-template<typename T>
-int ordered_set<T>::order_of_key(T key) const {
-    Node *u = root_.get();
-    int order = 0;
-    while (u) {
-        int l_size = u->child_[LEFT] ? u->child_[LEFT]->size_ : 0;
-        if (key == u->value_) return order + l_size;
-        if (key <= u->value_) {
-            u = u->child_[LEFT].get();
+TEMPLATE
+typename ORDERED_SET::size_type ORDERED_SET::order_of_key(const T &key) const {
+    tally(&ordered_set_stats::rank_queries);
+    return rank(key);
+}
+
+TEMPLATE
+template<typename K>
+typename ORDERED_SET::size_type ORDERED_SET::order_of_key(const K &key) const requires TRANSPARENT {
+    tally(&ordered_set_stats::rank_queries);
+    return rank(key);
+}
+
+// Returns the number of elements equal to key. In a multiset that's the number not greater than key minus the number less than it, two descents whatever the count.
+TEMPLATE
+typename ORDERED_SET::size_type ORDERED_SET::count(const T &key) const {
+    tally(&ordered_set_stats::rank_queries);
+    if constexpr (MULTI) return rank(key, true) - rank(key);
+    else return bool(locate(key));
+}
+
+TEMPLATE
+template<typename K>
+typename ORDERED_SET::size_type ORDERED_SET::count(const K &key) const requires TRANSPARENT {
+    tally(&ordered_set_stats::rank_queries);
+    if constexpr (MULTI) return rank(key, true) - rank(key);
+    else return bool(locate(key));
+}
+
+
+// Writes order_of_key(keys[i]) to out[i] for every i.
+// Sorted keys are answered in a single pass down the tree, splitting the batch at every node, so shared parts of the paths are walked once.
+// Otherwise BATCH_WIDTH descents are interleaved level by level, prefetching the next node of each.
+TEMPLATE
+void ORDERED_SET::order_of_keys(span<const T> keys, span<size_type> out) const {
+    if (out.size() < keys.size()) throw invalid_argument("Output span is smaller than the batch.");
+    if (is_sorted(keys.begin(), keys.end(), comparator())) return order_of_keys(root_, 0, keys.data(), keys.data() + keys.size(), out.data());
+    order_of_keys(keys, out.data(), nullptr);
+}
+
+// Like order_of_keys(keys, out), and also writes whether keys[i] is in the set to found[i].
+// The descents are always interleaved: each passes its key's lower_bound, so telling membership takes one more comparison per step to the left.
+TEMPLATE
+void ORDERED_SET::order_of_keys(span<const T> keys, span<size_type> out, span<bool> found) const {
+    if (out.size() < keys.size() || found.size() < keys.size()) throw invalid_argument("Output span is smaller than the batch.");
+    order_of_keys(keys, out.data(), found.data());
+}
+
+// The interleaved descents of order_of_keys, found being null when membership isn't asked for.
+TEMPLATE
+void ORDERED_SET::order_of_keys(span<const T> keys, size_type *out, bool *found) const {
+    // Ranks are counted as lower_bound's: going right past u adds size(u), arriving at a right child takes its size back off.
+    // Unlike order_of_key this never needs a left child's size, so each step only touches the node prefetched for it.
+    struct Descent {
+        link u;
+        size_type order;
+        bool from_right;
+    };
+    for (size_t first = 0; first < keys.size(); first += BATCH_WIDTH) {
+        size_t width = min(keys.size() - first, size_t(BATCH_WIDTH));
+        Descent descents[BATCH_WIDTH];
+        for (size_t i = 0; i < width; i++) descents[i] = {root_, 0, false};
+        if (found) fill(found + first, found + first + width, false);
+        for (bool active = true; active;) {
+            active = false;
+            for (size_t i = 0; i < width; i++) {
+                auto &[u, order, from_right] = descents[i];
+                if (!u) continue;
+                if (from_right) order -= node(u).size_;
+                from_right = compare(node(u).value_, keys[first + i]);
+                if (from_right) order += node(u).size_;
+                else if (found && !compare(keys[first + i], node(u).value_)) found[first + i] = true;
+                u = node(u).child_[from_right ? RIGHT : LEFT];
+                if (u) __builtin_prefetch(&node(u)), active = true;
+            }
+        }
+        for (size_t i = 0; i < width; i++) out[first + i] = descents[i].order;
+    }
+}
+
+// Writes find_by_order(orders[i]) to out[i] for every i, throwing out_of_range like find_by_order.
+// Sorted orders share a single pass down the tree, otherwise BATCH_WIDTH descents are interleaved, each prefetching the left child it needs the size of one round ahead.
+TEMPLATE
+void ORDERED_SET::find_by_orders(span<const size_type> orders, span<Iterator> out) const {
+    if (out.size() < orders.size()) throw invalid_argument("Output span is smaller than the batch.");
+    for (size_type k: orders) if (k > size()) throw out_of_range("Order out of range.");
+    if (is_sorted(orders.begin(), orders.end())) return find_by_orders(root_, 0, orders.data(), orders.data() + orders.size(), out.data());
+    
+    struct Descent {
+        link u;
+        size_type k;
+        bool ready;
+    };
+    for (size_t first = 0; first < orders.size(); first += BATCH_WIDTH) {
+        size_t width = min(orders.size() - first, size_t(BATCH_WIDTH));
+        Descent descents[BATCH_WIDTH];
+        for (size_t i = 0; i < width; i++) descents[i] = {orders[first + i] == size() ? link() : root_, orders[first + i], false};
+        for (bool active = true; active;) {
+            active = false;
+            for (size_t i = 0; i < width; i++) {
+                auto &[u, k, ready] = descents[i];
+                if (!u) continue;
+                active = true;
+                link left = node(u).child_[LEFT];
+                if (!ready) {
+                    if (left) __builtin_prefetch(&node(left));
+                    ready = true;
+                    continue;
+                }
+                size_type l_size = subtree_size(left);
+                ready = false;
+                if (l_size == k) {
+                    out[first + i] = Iterator(this, u);
+                    u = {};
+                } else if (l_size > k) {
+                    u = left;
+                } else {
+                    k -= l_size + 1;
+                    u = node(u).child_[RIGHT];
+                    __builtin_prefetch(&node(u));
+                }
+            }
+        }
+        for (size_t i = 0; i < width; i++) if (orders[first + i] == size()) out[first + i] = end();
+    }
+}
+
+// Answers the sorted keys in [first, last) within u's subtree, before being the number of elements left of the subtree.
+// In a multiset, elements equal to u's can also sit in its left subtree, so keys equal to u's go down there with the smaller ones, as in rank.
+TEMPLATE
+void ORDERED_SET::order_of_keys(link u, size_type before, const T *first, const T *last, size_type *out) const {
+    if (first == last) return;
+    if (!u) return (void) fill(out, out + (last - first), before);
+    
+    const T *middle = MULTI ? std::upper_bound(first, last, node(u).value_, comparator()) : std::lower_bound(first, last, node(u).value_, comparator());
+    order_of_keys(node(u).child_[LEFT], before, first, middle, out);
+    before += subtree_size(node(u).child_[LEFT]);
+    if constexpr (!MULTI) for (; middle != last && !compare(node(u).value_, *middle); middle++) out[middle - first] = before;
+    order_of_keys(node(u).child_[RIGHT], before + 1, middle, last, out + (middle - first));
+}
+
+TEMPLATE
+void ORDERED_SET::find_by_orders(link u, size_type before, const size_type *first, const size_type *last, Iterator *out) const {
+    if (first == last) return;
+    if (!u) return (void) fill(out, out + (last - first), end());
+    
+    size_type order = before + subtree_size(node(u).child_[LEFT]);
+    const size_type *middle = std::lower_bound(first, last, order);
+    find_by_orders(node(u).child_[LEFT], before, first, middle, out);
+    for (; middle != last && *middle == order; middle++) out[middle - first] = Iterator(this, u);
+    find_by_orders(node(u).child_[RIGHT], order + 1, middle, last, out + (middle - first));
+}
+
+// Returns the number of elements in [lo, hi), like order_of_key(hi) - order_of_key(lo) but walking the part of the two paths they share once.
+// Below the topmost node inside the range, each side compares against its own bound only, and the two sides are walked side by side, see count_sides.
+TEMPLATE
+typename ORDERED_SET::size_type ORDERED_SET::count_in_range(const T &lo, const T &hi) const {
+    tally(&ordered_set_stats::rank_queries);
+    if (!compare(lo, hi)) return 0;
+    link u = range_top(lo, hi);
+    if (!u) return 0;
+    auto [l_count, r_count] = count_sides(u, lo, hi);
+    return l_count + 1 + r_count;
+}
+
+// Returns an iterator to the k-th element after lower_bound(key) (lower_bound(key) itself for k = 0), or end() iterator if there are at most k elements from there on.
+// Like find_by_order(order_of_key(key) + k), but the second descent starts from the path to lower_bound(key) instead of the root:
+// the elements not less than key are, from the bottom of the path up, each node it leaves to the left followed by its right subtree.
+TEMPLATE
+iterator ORDERED_SET::kth_at_or_after(const T &key, size_type k) const {
+    tally(&ordered_set_stats::select_queries);
+    if (k >= KTH_CLIMB_MAX) {
+        // Compared against what's left so that rank + k can't wrap around.
+        size_type before = rank(key);
+        return k < size() - before ? Iterator(this, select(root_, before + k)) : end();
+    }
+    link stack[MAX_HEIGHT];
+    int top = 0;
+    for (link u = root_; u;) {
+        if (compare(node(u).value_, key)) u = node(u).child_[RIGHT];
+        else stack[top++] = u, u = node(u).child_[LEFT];
+    }
+    // The size of u's right subtree is taken from the sizes of u and its left child, which are on the path, so only the subtree the answer is in gets read.
+    while (top) {
+        link u = stack[--top];
+        if (k == 0) return Iterator(this, u);
+        k--;
+        size_type r_size = subtree_size(u) - subtree_size(node(u).child_[LEFT]) - 1;
+        if (k < r_size) return Iterator(this, select(node(u).child_[RIGHT], k));
+        k -= r_size;
+    }
+    return end();
+}
+
+// Returns an iterator to the q-quantile of the elements in [lo, hi) by the nearest-rank method: the least with at least q times their number not greater than it,
+// the least for q = 0. Returns end() iterator if the range is empty, and throws invalid_argument unless q is in [0, 1].
+// The range is counted as in count_in_range, and the rank is then found by sizes alone within one side of the topmost node inside the range.
+TEMPLATE
+iterator ORDERED_SET::quantile_in_range(const T &lo, const T &hi, double q) const {
+    if (!(q >= 0 && q <= 1)) throw invalid_argument("Quantiles lie in [0, 1].");
+    tally(&ordered_set_stats::select_queries);
+    if (!compare(lo, hi)) return end();
+    link u = range_top(lo, hi);
+    if (!u) return end();
+    
+    link left = node(u).child_[LEFT], right = node(u).child_[RIGHT];
+    auto [l_count, r_count] = count_sides(u, lo, hi);
+    size_type count = l_count + 1 + r_count;
+    auto rank = size_type(ceil(q * double(count)));
+    rank = rank ? min(rank, count) - 1 : 0;
+    if (rank < l_count) return Iterator(this, select(left, subtree_size(left) - l_count + rank));
+    if (rank == l_count) return Iterator(this, u);
+    return Iterator(this, select(right, rank - l_count - 1));
+}
+
+// Returns the augmentation's fold of the elements in [lo, hi), in order, in O(log(n)).
+// The paths to lo and hi share a prefix down to the first node inside the range, below it every node off the two boundaries contributes its whole subtree.
+TEMPLATE
+typename ORDERED_SET::aggregate_type ORDERED_SET::fold(const T &lo, const T &hi) const {
+    link u = range_top(lo, hi);
+    if (!u) return augmentation::identity();
+    
+    aggregate_type left = augmentation::identity(), right = augmentation::identity();
+    for (link v = node(u).child_[LEFT]; v;) {
+        if (compare(node(v).value_, lo)) {
+            v = node(v).child_[RIGHT];
         } else {
-            order += l_size + 1;
-            u = u->child_[RIGHT].get();
+            left = augmentation::combine(augmentation::combine(augmentation::lift(node(v).value_), aggregate(node(v).child_[RIGHT])), left);
+            v = node(v).child_[LEFT];
         }
     }
-    return order;
+    for (link v = node(u).child_[RIGHT]; v;) {
+        if (compare(node(v).value_, hi)) {
+            right = augmentation::combine(right, augmentation::combine(aggregate(node(v).child_[LEFT]), augmentation::lift(node(v).value_)));
+            v = node(v).child_[RIGHT];
+        } else {
+            v = node(v).child_[LEFT];
+        }
+    }
+    return augmentation::combine(augmentation::combine(left, augmentation::lift(node(u).value_)), right);
+}
+
+// Calls f on every element in order, like iterating from begin() to end() but without climbing back up through parents, see scan.
+TEMPLATE
+template<typename F>
+void ORDERED_SET::for_each(F f) const {
+    tally(&ordered_set_stats::lookups);
+    link stack[MAX_HEIGHT];
+    int top = 0;
+    for (link u = root_; u; u = node(u).child_[LEFT]) stack[top++] = u;
+    scan(stack, top, {}, f);
+}
+
+// Calls f on every element in [lo, hi) in order, in O(log(n) + k) for k elements.
+// One descent finds where the range ends, so the scan itself doesn't compare, and nothing throws unless f does.
+TEMPLATE
+template<typename F>
+void ORDERED_SET::for_each_in_range(const T &lo, const T &hi, F f) const {
+    tally(&ordered_set_stats::lookups);
+    if (!compare(lo, hi)) return;
+    link stack[MAX_HEIGHT];
+    int top = 0;
+    // The path to lower_bound(lo), keeping the nodes whose left subtree it enters, as they come after it.
+    for (link u = root_; u;) {
+        if (compare(node(u).value_, lo)) u = node(u).child_[RIGHT];
+        else stack[top++] = u, u = node(u).child_[LEFT];
+    }
+    scan(stack, top, bound(hi, false), f);
 }
 
 
 // Inserting
 
-template<typename T>
-pair<iterator, bool> ordered_set<T>::insert(Node *u) {
-    if (!root_) {
-        root_.reset(u);
-        u->color_ = BLACK;
-        return {Iterator(this, u), true};
+// Attempts to insert key into the set. Returns a pair, the first element is an iterator that points to the possibly inserted element, and the second is a bool that is true if the element was actually inserted.
+// The node is only taken from the pool once the key is known to be missing, and an rvalue key is moved into it.
+TEMPLATE
+pair<iterator, bool> ORDERED_SET::insert(const T &key) {
+    tally(&ordered_set_stats::inserts);
+    return insert_unique(key);
+}
+
+TEMPLATE
+pair<iterator, bool> ORDERED_SET::insert(T &&key) {
+    tally(&ordered_set_stats::inserts);
+    return insert_unique(std::move(key));
+}
+
+// Constructs the element in a node from args, then inserts it like insert, giving the node back if an equal element exists.
+TEMPLATE
+template<typename... Args>
+pair<iterator, bool> ORDERED_SET::emplace(Args &&... args) {
+    tally(&ordered_set_stats::inserts);
+    link u = pool().allocate(std::forward<Args>(args)...);
+    auto made = [u] { return u; };
+    auto [it, inserted] = SINGLE_PASS ? insert_single_pass(node(u).value_, made) : insert_node(node(u).value_, made);
+    if (!inserted) pool_->deallocate(u);
+    return {it, inserted};
+}
+
+TEMPLATE
+template<typename K>
+pair<iterator, bool> ORDERED_SET::insert_unique(K &&key) {
+    auto make = [&] { return pool().allocate(std::forward<K>(key)); };
+    if constexpr (SINGLE_PASS) return insert_single_pass(key, make);
+    else return insert_node(key, make);
+}
+
+// Inserts the element make() returns unless one equal to key is already there, which is returned instead, in a single descent.
+// make() is only called once key is known to be missing, so containers built on the set can construct their elements lazily (see ordered_map::try_emplace).
+TEMPLATE
+template<typename K, typename Make>
+pair<iterator, bool> ORDERED_SET::insert_missing(const K &key, Make make) {
+    tally(&ordered_set_stats::inserts);
+    auto allocate = [&] { return pool().allocate(make()); };
+    if constexpr (SINGLE_PASS) return insert_single_pass(key, allocate);
+    else return insert_node(key, allocate);
+}
+
+// Links in the node make() returns where key belongs, unless an equal element is already there, which is returned instead.
+// The place is found first and make() called only then, so nothing is allocated for a key that's there. In a multiset the node goes after the elements equal to it.
+TEMPLATE
+template<typename K, typename Make>
+pair<iterator, bool> ORDERED_SET::insert_node(const K &key, Make make) {
+    link current = root_, parent = {};
+    Direction direction = LEFT;
+    int depth = 0;
+    for (; current; depth++) {
+        if (compare(key, node(current).value_)) direction = LEFT;
+        else if (MULTI || compare(node(current).value_, key)) direction = RIGHT;
+        else break;
+        parent = current;
+        current = node(current).child_[direction];
     }
-    Node *current = root_.get(), *parent = nullptr;
-    Direction direction;
-    while (current) {
-        if (u->value_ == current->value_) {
-            delete u;
-            return {Iterator(this, current), false};
+    tally_descent(current ? depth + 1 : depth);
+    if (current) return {Iterator(this, current), false};
+    link u = make();
+    if (!parent) {
+        root_ = u;
+        node(root_).color_ = BLACK;
+        return {Iterator(this, root_), true};
+    }
+    add_child(parent, u, direction);
+    add_size(parent, 1);
+    insert_fix(u);
+    return {Iterator(this, u), true};
+}
+
+// Links in the node make() returns where key belongs, like insert_node, but rebalances on the way down (Guibas and Sedgewick):
+// a black node with two red children swaps colors with them, and if that puts two reds in a row, restructure fixes them, the uncle being black as it was checked on the way down.
+// The new node's parent is then never a black node with two red children, so linking it in takes one restructure at most.
+// Sizes are counted up on the way down, and back down if an equal element is there, which is returned instead. make() is only called once key is known to be missing.
+TEMPLATE
+template<typename K, typename Make>
+pair<iterator, bool> ORDERED_SET::insert_single_pass(const K &key, Make make) {
+    // Augmented trees recompute sizes along with their aggregates on the way back up instead.
+    constexpr int delta = AUGMENTED ? 0 : 1;
+    link current = root_, parent = {}, candidate = {};
+    Direction direction = LEFT;
+    int depth = 0;
+    for (; current; depth++) {
+        link left = node(current).child_[LEFT], right = node(current).child_[RIGHT];
+        if (color(left) == RED && color(right) == RED) {
+            tally(&ordered_set_stats::recolors);
+            node(left).color_ = node(right).color_ = BLACK;
+            if (current != root_) {
+                node(current).color_ = RED;
+                // restructure sizes the nodes it rotates from their children, so one it lifts above current misses the new node.
+                if (node(node(current).parent_).color_ == RED) {
+                    link top = restructure(current);
+                    if (top != current) node(top).size_ += delta;
+                }
+            }
         }
-        if (u->value_ < current->value_) {
-            parent = current;
-            current = current->child_[LEFT].get();
+        // One comparison per level, the last node that isn't greater than key being the only one that can be equal to it.
+        if (compare(key, node(current).value_)) {
             direction = LEFT;
         } else {
-            parent = current;
-            current = current->child_[RIGHT].get();
             direction = RIGHT;
+            candidate = current;
         }
+        node(current).size_ += delta;
+        parent = current;
+        current = node(current).child_[direction];
+    }
+    tally_descent(depth);
+    if (!MULTI && candidate && !compare(node(candidate).value_, key)) {
+        add_path_size(parent, {}, -delta);
+        return {Iterator(this, candidate), false};
+    }
+    link u;
+    try {
+        u = make();
+    } catch (...) {
+        add_path_size(parent, {}, -delta);
+        throw;
+    }
+    if (!parent) {
+        root_ = u;
+        node(root_).color_ = BLACK;
+        return {Iterator(this, root_), true};
     }
     add_child(parent, u, direction);
-    update_size(parent);
-    insert_fix(u);
-    return {iterator(this, u), true};
+    if (node(parent).color_ == RED) restructure(u);
+    if constexpr (AUGMENTED) update_size(u);
+    return {Iterator(this, u), true};
 }
 
-// Attempts to insert key into the set. Returns a pair, the first element is an iterator that points to the possibly inserted element, and the second is a bool that is true if the element was actually inserted.
-template<typename T>
-pair<iterator, bool> ordered_set<T>::insert(T key) { return insert(new Node(key)); }
+// Inserts key right before hint when it belongs there, without descending from the root, otherwise like insert(key).
+// Appending at end() or prepending at begin() only compares key with its neighbors.
+// In a multiset key belongs there only if it's less than hint's element, as equal elements stay in insertion order.
+TEMPLATE
+iterator ORDERED_SET::insert(Iterator hint, const T &key) {
+    tally(&ordered_set_stats::inserts);
+    return insert_hint(hint.ptr_, key);
+}
 
-template<typename T>
-void ordered_set<T>::insert_fix(Node *u) {
-    // Only called on a red node.
-    assert(u->color_ == RED);
-    
-    Node *parent = u->parent_;
+TEMPLATE
+iterator ORDERED_SET::insert(Iterator hint, T &&key) {
+    tally(&ordered_set_stats::inserts);
+    return insert_hint(hint.ptr_, std::move(key));
+}
+
+TEMPLATE
+template<typename K>
+iterator ORDERED_SET::insert_hint(link next, K &&key) {
+    link prev = neighbor(next, LEFT);
+    bool misplaced = MULTI ? (next && !compare(key, node(next).value_)) || (prev && compare(key, node(prev).value_))
+                           : (next && !compare(key, node(next).value_)) || (prev && !compare(node(prev).value_, key));
+    if (misplaced) return insert_unique(std::forward<K>(key)).first;
     
-    if (!parent) {
-        u->color_ = BLACK;
-        return;
+    link u = pool().allocate(std::forward<K>(key));
+    if (!root_) {
+        root_ = u;
+        node(root_).color_ = BLACK;
+        return Iterator(this, u);
     }
-    
-    if (parent->color_ == BLACK)
+    // prev and next are adjacent, so one of them is a descendant of the other, and that one has a free slot facing it.
+    link parent = prev && !node(prev).child_[RIGHT] ? prev : next;
+    add_child(parent, u, parent == prev ? RIGHT : LEFT);
+    add_size(parent, 1);
+    insert_fix(u);
+    return Iterator(this, u);
+}
+
+// Inserts every element in [first, last).
+// Batches that are large relative to the set are merged with it in one linear pass, and the tree is rebuilt balanced out of the same nodes, so iterators stay valid.
+// Sorted forward ranges are merged in place, anything else is copied and sorted first.
+TEMPLATE
+template<typename InputIt>
+void ORDERED_SET::insert(InputIt first, InputIt last) {
+    tally(&ordered_set_stats::bulk_operations);
+    if constexpr (is_base_of_v<forward_iterator_tag, typename iterator_traits<InputIt>::iterator_category>) {
+        if (size_type(distance(first, last)) * BULK_RATIO < size()) {
+            for (; first != last; ++first) insert(*first);
+            return;
+        }
+        if (is_sorted(first, last, comparator())) return merge_sorted(first, last);
+    }
+    vector<T> values(first, last);
+    if (values.size() * BULK_RATIO < size()) {
+        for (T &value: values) insert(std::move(value));
         return;
+    }
+    sort(values.begin(), values.end(), comparator());
+    merge_sorted(make_move_iterator(values.begin()), make_move_iterator(values.end()));
+}
+
+// Flattens the tree into a vine (an in-order list chained through right children), splices new nodes for the missing values of the sorted range into it, and rebuilds.
+TEMPLATE
+template<typename ForwardIt>
+void ORDERED_SET::merge_sorted(ForwardIt first, ForwardIt last) {
+    size_type n = size();
     
+    // Right rotations at every node with a left child straighten the tree without extra memory.
+    link head = {}, tail = {}, rest = root_;
+    while (rest) {
+        link left = node(rest).child_[LEFT];
+        if (left) {
+            node(rest).child_[LEFT] = node(left).child_[RIGHT];
+            node(left).child_[RIGHT] = rest;
+            rest = left;
+        } else {
+            (tail ? node(tail).child_[RIGHT] : head) = rest;
+            tail = rest;
+            rest = node(rest).child_[RIGHT];
+        }
+    }
     
-    Direction direction = get_direction(u);
-    Direction p_direction = get_direction(parent);
+    link prev = {}, current = head;
+    for (; first != last; ++first) {
+        while (current && (MULTI ? !compare(*first, node(current).value_) : compare(node(current).value_, *first))) prev = current, current = node(current).child_[RIGHT];
+        if (!MULTI && ((current && !compare(*first, node(current).value_)) || (prev && !compare(node(prev).value_, *first)))) continue;
+        link u = pool().allocate(*first);
+        node(u).child_[RIGHT] = current;
+        (prev ? node(prev).child_[RIGHT] : head) = u;
+        prev = u;
+        n++;
+    }
     
-    Node *grandparent = parent->parent_;
-    Node *uncle = grandparent->child_[!p_direction].get();
+    root_ = build(head, n, 0, int(bit_width(n)) - 1);
+    if (root_) node(root_).parent_ = {};
+}
+
+// Turns the first n nodes of the vine at head into a perfectly balanced subtree rooted at the given depth, advancing head past them.
+// Every level but the deepest one (red_depth) is full, so coloring that level red and the rest black keeps black depths equal.
+TEMPLATE
+typename ORDERED_SET::link ORDERED_SET::build(link &head, size_type n, int depth, int red_depth) {
+    if (!n) return {};
     
-    // Parent is red(1), and thus not the root(2). So, grandparent exists(2) and is black(1).
-    assert(grandparent->color_ == BLACK);
+    link left = build(head, (n - 1) / 2, depth + 1, red_depth);
+    link u = head;
+    head = node(u).child_[RIGHT];
+    link right = build(head, n - 1 - (n - 1) / 2, depth + 1, red_depth);
     
-    if (!uncle || uncle->color_ == BLACK) {
-        // The fix ends here, at most 2 rotations to be done.
-        if (direction != p_direction) {
-            // Make u the outer child, rotation won't cause violations as both u and parent are red.
-            rotate(parent, !direction);
-            swap(u, parent);
+    node(u).child_[LEFT] = left;
+    node(u).child_[RIGHT] = right;
+    if (left) node(left).parent_ = u;
+    if (right) node(right).parent_ = u;
+    update_size(u, false);
+    node(u).color_ = depth && depth == red_depth ? RED : BLACK;
+    return u;
+}
+
+// Returns true if the fix reached the root and blackened it, which makes the tree's black height grow by one.
+// Loops up the tree two levels at a time instead of recursing on the grandparent.
+TEMPLATE
+bool ORDERED_SET::insert_fix(link u) {
+    while (true) {
+        // Only called on a red node.
+        assert(node(u).color_ == RED);
+        
+        link parent = node(u).parent_;
+        
+        if (!parent) {
+            tally(&ordered_set_stats::recolors);
+            node(u).color_ = BLACK;
+            return true;
         }
-        // Rotate grandparent to get parent on top and swap colors with it. No more red violations and the black depth is the same for the (now parent's) subtree.
-        rotate(grandparent, !p_direction);
-        grandparent->color_ = RED;
-        parent->color_ = BLACK;
-    } else {
-        // The recursive part.
+        
+        if (node(parent).color_ == BLACK)
+            return false;
+        
+        tally(&ordered_set_stats::recolors);
+        
+        
+        Direction p_direction = get_direction(parent);
+        
+        link grandparent = node(parent).parent_;
+        link uncle = node(grandparent).child_[!p_direction];
+        
+        // Parent is red(1), and thus not the root(2). So, grandparent exists(2) and is black(1).
+        assert(node(grandparent).color_ == BLACK);
+        
+        if (color(uncle) == BLACK) {
+            // The fix ends here, at most 2 rotations to be done.
+            restructure(u);
+            return false;
+        }
+        // The repeating part.
         // Propagate black from grandparent down to parent and uncle.
-        grandparent->color_ = RED;
-        parent->color_ = uncle->color_ = BLACK;
-        // Grandparent is red, and we don't know about its parent, call insert_fix on it again.
-        insert_fix(grandparent);
+        node(grandparent).color_ = RED;
+        node(parent).color_ = node(uncle).color_ = BLACK;
+        // Grandparent is red, and we don't know about its parent, fix it next.
+        u = grandparent;
     }
-    
+}
+
+// Fixes a red u under a red parent whose sibling is black, by one rotation at the grandparent if u is an outer child, or two if it's an inner one.
+// Returns the node that takes the grandparent's place, which is black with two red children.
+TEMPLATE
+typename ORDERED_SET::link ORDERED_SET::restructure(link u) {
+    link parent = node(u).parent_, grandparent = node(parent).parent_;
+    Direction direction = get_direction(u), p_direction = get_direction(parent);
+    if (direction != p_direction) {
+        // Make u the outer child, rotation won't cause violations as both u and parent are red.
+        rotate(parent, !direction);
+        swap(u, parent);
+    }
+    // Rotate grandparent to get parent on top and swap colors with it. No more red violations and the black depth is the same for the (now parent's) subtree.
+    rotate(grandparent, !p_direction);
+    node(grandparent).color_ = RED;
+    node(parent).color_ = BLACK;
+    return parent;
 }
 
 
 // Erasing
 
-template<typename T>
-bool ordered_set<T>::erase(Node *u) {
+TEMPLATE
+bool ORDERED_SET::erase(link u) {
     if (!u) return false; // Doesn't exist
     
-    if (u->child_[LEFT] && u->child_[RIGHT]) {
+    if (node(u).child_[LEFT] && node(u).child_[RIGHT]) {
         // Go to the successor of the node, which is the one with the least value in the right child subtree.
-        // It can't have a left child, so it will have at most one child.
-        Node *v = u->child_[RIGHT].get();
-        while (v->child_[LEFT]) v = v->child_[LEFT].get();
-        swap(u->value_, v->value_);
-        u = v;
+        // It can't have a left child, so once u takes its place it will have at most one child.
+        link v = node(u).child_[RIGHT];
+        while (node(v).child_[LEFT]) v = node(v).child_[LEFT];
+        swap_with_successor(u, v);
     }
     
-    if (!u->child_[LEFT] && !u->child_[RIGHT]) {
-        if (!u->parent_) {
-            clear();
-            return true;
+    if (!node(u).child_[LEFT] && !node(u).child_[RIGHT]) {
+        link p = node(u).parent_;
+        if (!p) {
+            root_ = {};
+        } else if (node(u).color_ == RED) {
+            node(p).child_[get_direction(u)] = {};
+            add_size(p, -1);
+        } else {
+            // Black non-root leaf.
+            // Let u stand in for the missing subtree while fixing: with a size of 0 and an empty aggregate it's already out of every count, and it's detached afterwards.
+            node(u).size_ = 0;
+            if constexpr (AUGMENTED) node(u).aggregate_ = augmentation::identity();
+            add_size(p, -1);
+            erase_fix(u);
+            node(node(u).parent_).child_[get_direction(u)] = {};
         }
-        if (u->color_ == RED) {
-            Node *p = u->parent_;
-            p->child_[get_direction(u)].reset();
-            update_size(p);
-            return true;
+        pool_->deallocate(u);
+        return true;
+    }
+    Direction c_direction = node(u).child_[RIGHT] ? RIGHT : LEFT;
+    link child = node(u).child_[c_direction];
+    
+    // Non-leaf with one child. So, child is a red leaf, and u has to be black.
+    assert(node(child).color_ == RED && node(child).size_ == 1 && node(u).color_ == BLACK);
+    // Replace u with child and color it black. No fixes needed.
+    node(child).parent_ = node(u).parent_;
+    node(child).color_ = BLACK;
+    (node(u).parent_ ? node(node(u).parent_).child_[get_direction(u)] : root_) = child;
+    pool_->deallocate(u);
+    
+    add_size(node(child).parent_, -1);
+    return true;
+}
+
+// Attempts to erase key from the set. Returns true if the key existed and was erased.
+TEMPLATE
+bool ORDERED_SET::erase(const T &key) {
+    tally(&ordered_set_stats::erases);
+    if constexpr (SINGLE_PASS) return erase_single_pass(key);
+    return erase(locate(key));
+}
+
+TEMPLATE
+template<typename K>
+bool ORDERED_SET::erase(const K &key) requires TRANSPARENT {
+    tally(&ordered_set_stats::erases);
+    if constexpr (SINGLE_PASS) return erase_single_pass(key);
+    return erase(locate(key));
+}
+
+// Erases the first element equal to key like erase(locate(key)), in a single descent that counts sizes down on the way (and back up if key isn't there).
+// The descent goes on past the element to its predecessor, which has at most one child. That node is cut out, fixing the tree from there like erase(link) does,
+// and then takes the element's place, so no value moves and iterators stay valid.
+TEMPLATE
+template<typename K>
+bool ORDERED_SET::erase_single_pass(const K &key) {
+    // Augmented trees recompute sizes along with their aggregates on the way back up instead.
+    constexpr int delta = AUGMENTED ? 0 : 1;
+    link current = root_, candidate = {};
+    Direction direction = LEFT;
+    int depth = 0;
+    while (current) {
+        depth++;
+        // The last node not less than key is the only one that can be equal to it, as for bound.
+        direction = compare(node(current).value_, key) ? RIGHT : LEFT;
+        if (direction == LEFT) candidate = current;
+        link next = node(current).child_[direction];
+        if (!next) break;
+        node(current).size_ -= delta;
+        current = next;
+    }
+    tally_descent(depth);
+    if (!candidate || compare(key, node(candidate).value_)) {
+        if (current) add_path_size(node(current).parent_, {}, delta);
+        return false;
+    }
+    
+    // current is the predecessor of candidate, or candidate itself if it has no left child, either way without a child on the side the descent left through.
+    link parent = node(current).parent_, child = node(current).child_[!direction];
+    if (child) {
+        // A single child is a red leaf under a black node, so it takes current's place turning black.
+        node(child).parent_ = parent;
+        node(child).color_ = BLACK;
+        (parent ? node(parent).child_[get_direction(current)] : root_) = child;
+    } else if (!parent) {
+        root_ = {};
+    } else if (node(current).color_ == RED) {
+        node(parent).child_[get_direction(current)] = {};
+    } else {
+        // Black non-root leaf, which stands in for the missing subtree while fixing, as in erase(link).
+        node(current).size_ = 0;
+        if constexpr (AUGMENTED) {
+            node(current).aggregate_ = augmentation::identity();
+            update_size(parent);
+        }
+        erase_fix(current);
+        parent = node(current).parent_;
+        node(parent).child_[get_direction(current)] = {};
+    }
+    if (candidate != current) {
+        // current takes over candidate's place, color and size.
+        link up = node(candidate).parent_;
+        (up ? node(up).child_[get_direction(candidate)] : root_) = current;
+        node(current).parent_ = up;
+        for (Direction d: {LEFT, RIGHT}) {
+            node(current).child_[d] = node(candidate).child_[d];
+            if (node(current).child_[d]) node(node(current).child_[d]).parent_ = current;
         }
-        // Black non-root leaf.
-        // Replace u with a black dummy node and start fixing from dummy
-        Node *dummy = new Node();
-        dummy->size_ = 0;
-        dummy->color_ = BLACK;
+        node(current).color_ = node(candidate).color_;
+        node(current).size_ = node(candidate).size_;
+        if (parent == candidate) parent = current;
+    }
+    if constexpr (AUGMENTED) {
+        if (parent) update_size(parent);
+    }
+    pool_->deallocate(candidate);
+    return true;
+}
+
+// Erases the element at pos without searching for it, returning an iterator to the element after it.
+// Nodes never move, so iterators to the other elements stay valid.
+TEMPLATE
+iterator ORDERED_SET::erase(Iterator pos) {
+    tally(&ordered_set_stats::erases);
+    if (!pos.ptr_) throw out_of_range("Erasing end iterator.");
+    link next = neighbor(pos.ptr_, RIGHT);
+    erase(pos.ptr_);
+    return Iterator(this, next);
+}
+
+// Erases the elements in [first, last), returning last.
+// Short ranges are erased one by one, longer ones are split out of the tree and freed, in O(log(n) + k) for k elements.
+TEMPLATE
+iterator ORDERED_SET::erase(Iterator first, Iterator last) {
+    tally(&ordered_set_stats::bulk_operations);
+    size_type lo = first.order(), hi = last.order();
+    if (lo > hi) throw invalid_argument("Erased range must not end before it starts.");
+    if (hi - lo < SPLIT_ERASE_MIN) {
+        while (first != last) first = erase(first);
+        return last;
+    }
+    auto [l, rest] = split_by_order({root_, black_height(root_)}, lo);
+    auto [range, r] = split_by_order(rest, hi - lo);
+    free_subtree(range.root);
+    root_ = join(l, r).root;
+    return last;
+}
+
+// Loops up the tree while the missing black can only be pushed to the parent, instead of recursing on it.
+TEMPLATE
+void ORDERED_SET::erase_fix(link u) {
+    while (true) {
+        // Only called on a black node
+        assert(node(u).color_ == BLACK);
+        link parent = node(u).parent_;
+        
+        if (!parent)
+            return;
         
-        Node *p = u->parent_;
+        tally(&ordered_set_stats::recolors);
         Direction direction = get_direction(u);
+        link sibling = node(parent).child_[!direction];
+        link close_nephew = node(sibling).child_[direction];
+        link distant_nephew = node(sibling).child_[!direction];
         
-        p->child_[direction].reset();
-        add_child(p, dummy, direction);
+        // Sibling must exist, since if it's nullptr, its black depth is less than u's subtree.
+        // Nephews may not exist if erase_fix is called on the erased leaf (first call)
         
-        update_size(dummy->parent_);
-        erase_fix(dummy);
-        dummy->parent_->child_[get_direction(dummy)].reset();
-        return true;
+        if (node(parent).color_ == BLACK && node(sibling).color_ == BLACK && color(close_nephew) == BLACK && color(distant_nephew) == BLACK) {
+            // Go up.
+            node(sibling).color_ = RED;
+            u = parent;
+            continue;
+        }
+        
+        if (node(sibling).color_ == RED) {
+            // Now nephews must both exist and be black, rotate the parent to u's direction and swap its color with the (previously) sibling, then continue fixing from u.
+            swap_colors(parent, sibling);
+            rotate(parent, direction);
+            sibling = close_nephew;
+            close_nephew = node(sibling).child_[direction];
+            distant_nephew = node(sibling).child_[!direction];
+            // close nephew is now the sibling, so sibling is black.
+        }
+        
+        // u and sibling are black. at least one of the involved nodes is red
+        
+        if (color(close_nephew) == BLACK && color(distant_nephew) == BLACK) {
+            // parent is currently the only unchecked node, so it's red.
+            // push the sibling's black to the parent, now both subtrees have the same black depth.
+            swap_colors(parent, sibling);
+            return;
+        }
+        
+        // at least one nephew exists and is red, we need it to be the distant one for the final fix.
+        
+        if (color(distant_nephew) == BLACK) {
+            // close nephew is the red one, some rotations and changing colors will do.
+            swap_colors(sibling, close_nephew);
+            rotate(sibling, !direction);
+            sibling = close_nephew;
+            close_nephew = node(sibling).child_[direction];
+            distant_nephew = node(sibling).child_[!direction];
+            // Now sibling is still black, but distant nephew is red.
+        }
+        
+        // Parent's color is x, sibling is black, distant nephew is red, close nephew's color doesn't matter.
+        // u's subtree needs to pass through an extra black node to the root.
+        node(distant_nephew).color_ = BLACK;
+        swap_colors(parent, sibling);
+        rotate(parent, direction);
+        // close nephew's subtree passes through the same nodes (parent and sibling with black and x colors), no changes in black depth.
+        // Distant nephew's subtree passes through the black added to distant nephew instead of the sibling's black (swapped to parent), no changes in black depth.
+        // u's subtree passes through an extra black from the sibling, fixed.
+        return;
     }
-    Direction c_direction = u->child_[RIGHT] ? RIGHT : LEFT;
+}
+
+
+// Saving and Loading
 
-#pragma clang diagnostic push
-#pragma ide diagnostic ignored "NullDereference"
-    Node *child = u->child_[c_direction].release();
-#pragma clang diagnostic pop
+// Writes the elements to path in order, after an ordered_set_file_header, in O(n).
+TEMPLATE
+void ORDERED_SET::save(const string &path) const requires is_trivially_copyable_v<T> {
+    ofstream out(path, ios::binary);
+    if (!out) throw runtime_error("Can't open " + path + " for writing.");
     
-    // Non-leaf with one child. So, child is a red leaf, and u has to be black.
-    assert(child->color_ == RED && child->size_ == 1 && u->color_ == BLACK);
-    // Replace u with child and color it black. No fixes needed.
-    child->parent_ = u->parent_;
-    child->color_ = BLACK;
-    unique_ptr<Node> &ptr = u->parent_ ? u->parent_->child_[get_direction(u)] : root_;
-    ptr.reset(child);
+    ordered_set_file_header header{};
+    memcpy(header.magic, header.MAGIC, sizeof header.magic);
+    header.version = header.VERSION;
+    header.element_size = sizeof(T);
+    header.size = size();
+    // Written again once the checksum is known.
+    out.write(reinterpret_cast<const char *>(&header), sizeof header);
     
-    update_size(child);
-    return true;
+    checksum64 checksum;
+    vector<T> chunk;
+    chunk.reserve(FILE_CHUNK);
+    auto flush = [&] {
+        checksum.update(chunk.data(), chunk.size() * sizeof(T));
+        out.write(reinterpret_cast<const char *>(chunk.data()), streamsize(chunk.size() * sizeof(T)));
+        chunk.clear();
+    };
+    for (Iterator it = begin(); it != end(); ++it) {
+        chunk.push_back(*it);
+        if (chunk.size() == FILE_CHUNK) flush();
+    }
+    flush();
+    
+    header.checksum = checksum.value();
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof header);
+    if (!out.flush()) throw runtime_error("Failed writing " + path + ".");
 }
 
-// Attempts to erase key from the set. Returns true if the key existed and was erased.
-template<typename T>
-bool ordered_set<T>::erase(T key) {
-    Node *u = root_.get();
+// Replaces the elements with the ones saved to path, chaining them in file order and building the balanced tree over them in O(n), without a single comparison.
+// Throws runtime_error, leaving the set empty, if the file is not a valid save of this element type.
+TEMPLATE
+void ORDERED_SET::load(const string &path) requires is_trivially_copyable_v<T> {
+    tally(&ordered_set_stats::bulk_operations);
+    clear();
+    ifstream in(path, ios::binary);
+    if (!in) throw runtime_error("Can't open " + path + ".");
+    ordered_set_file_header header{};
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof header)) throw runtime_error("Not an ordered_set file.");
+    header.check(sizeof(T));
+    
+    checksum64 checksum;
+    vector<byte> chunk(FILE_CHUNK * sizeof(T));
+    link head = {}, tail = {};
+    if (header.size > max_size()) throw runtime_error("The file holds too many elements.");
+    size_type n = 0;
+    while (n < header.size) {
+        size_t count = min(size_t(header.size - n), FILE_CHUNK);
+        if (!in.read(reinterpret_cast<char *>(chunk.data()), streamsize(count * sizeof(T)))) break;
+        checksum.update(chunk.data(), count * sizeof(T));
+        for (size_t i = 0; i < count; i++) {
+            array<byte, sizeof(T)> bytes;
+            memcpy(bytes.data(), chunk.data() + i * sizeof(T), sizeof(T));
+            link u = pool().allocate(bit_cast<T>(bytes));
+            (tail ? node(tail).child_[RIGHT] : head) = u;
+            tail = u;
+        }
+        n += size_type(count);
+    }
+    
+    // Built even from a bad file, so that clear() can free the nodes.
+    root_ = build(head, n, 0, int(bit_width(n)) - 1);
+    if (root_) node(root_).parent_ = {};
+    if (n < header.size || checksum.value() != header.checksum) {
+        clear();
+        throw runtime_error(n < header.size ? "Truncated ordered_set file." : "Checksum mismatch in " + path + ".");
+    }
+}
+
+
+// Splitting and Joining
+
+// Moves the elements not less than key out into the returned set in O(log(n)). Both sets share a node pool from then on.
+TEMPLATE
+ORDERED_SET ORDERED_SET::split(const T &key) {
+    if constexpr (MULTI) return split_by_order(rank(key));
+    tally(&ordered_set_stats::bulk_operations);
+    auto [l, found, r] = split({root_, black_height(root_)}, key);
+    if (found) r = join({}, found, r);
+    root_ = l.root;
+    return ordered_set(pool_, r.root, comp_);
+}
+
+// Keeps the k smallest elements and moves the rest out into the returned set in O(log(n)). Both sets share a node pool from then on.
+TEMPLATE
+ORDERED_SET ORDERED_SET::split_by_order(size_type k) {
+    tally(&ordered_set_stats::bulk_operations);
+    if (k > size()) throw out_of_range("Order out of range.");
+    auto [l, r] = split_by_order({root_, black_height(root_)}, k);
+    root_ = l.root;
+    return ordered_set(pool_, r.root, comp_);
+}
+
+// Appends the elements of other, which must all be greater than this set's, leaving other empty.
+// O(log(n)) when the sets share a node pool, otherwise other's elements are moved to this set's pool first, in O(size of other).
+TEMPLATE
+void ORDERED_SET::join(ordered_set &&other) {
+    tally(&ordered_set_stats::bulk_operations);
+    if (!empty() && !other.empty() && (MULTI ? compare(*other.begin(), *--end()) : !compare(*--end(), *other.begin())))
+        throw invalid_argument("Joined set must be greater than this set.");
+    share_pool(other);
+    root_ = join({root_, black_height(root_)}, {other.root_, black_height(other.root_)}).root;
+    other.root_ = {};
+}
+
+// Frees every node of the subtree at u, bottom-up.
+TEMPLATE
+void ORDERED_SET::free_subtree(link u) {
     while (u) {
-        if (key == u->value_) break;
-        if (key < u->value_) u = u->child_[LEFT].get();
-        else u = u->child_[RIGHT].get();
+        if (node(u).child_[LEFT]) u = node(u).child_[LEFT];
+        else if (node(u).child_[RIGHT]) u = node(u).child_[RIGHT];
+        else {
+            link parent = node(u).parent_;
+            if (parent) node(parent).child_[get_direction(u)] = {};
+            pool_->deallocate(u);
+            u = parent;
+        }
     }
-    return erase(u);
 }
 
-template<typename T>
-void ordered_set<T>::erase_fix(Node *u) {
-    // Only called on a black node
-    assert(u->color_ == BLACK);
-    Node *parent = u->parent_;
+TEMPLATE
+int ORDERED_SET::black_height(link u) const {
+    int height = 0;
+    for (; u; u = node(u).child_[LEFT]) height += node(u).color_ == BLACK;
+    return height;
+}
+
+// Checks the subtree at u, at the given depth, for validate(), prev being the node before it in order, which is then moved to the subtree's last node.
+// Returns the subtree's black height. Compares with comp_ directly, so that validating doesn't show up in the stats.
+TEMPLATE
+int ORDERED_SET::validate(link u, int depth, link &prev, ordered_set_shape &shape) const {
+    if (!u) return 0;
+    if (int(shape.depth_histogram.size()) <= depth) shape.depth_histogram.resize(depth + 1);
+    shape.depth_histogram[depth]++;
     
-    if (!parent)
-        return;
+    for (Direction direction: {LEFT, RIGHT}) {
+        link child = node(u).child_[direction];
+        if (child && node(child).parent_ != u) throw logic_error("Child not linked back to its parent.");
+        if (node(u).color_ == RED && color(child) == RED) throw logic_error("Red node with a red child.");
+    }
+    int l_height = validate(node(u).child_[LEFT], depth + 1, prev, shape);
+    if (prev && (MULTI ? comp_(node(u).value_, node(prev).value_) : !comp_(node(prev).value_, node(u).value_))) throw logic_error("Elements out of order.");
+    prev = u;
+    int r_height = validate(node(u).child_[RIGHT], depth + 1, prev, shape);
     
-    Direction direction = get_direction(u);
-    Node *sibling = parent->child_[!direction].get();
-    Node *close_nephew = sibling->child_[direction].get();
-    Node *distant_nephew = sibling->child_[!direction].get();
+    if (l_height != r_height) throw logic_error("Black heights differ.");
+    if (node(u).size_ != 1 + subtree_size(node(u).child_[LEFT]) + subtree_size(node(u).child_[RIGHT])) throw logic_error("Wrong subtree size.");
+    if constexpr (AUGMENTED && equality_comparable<aggregate_type>) {
+        if (!(node(u).aggregate_ == augmentation::combine(augmentation::combine(aggregate(node(u).child_[LEFT]), augmentation::lift(node(u).value_)), aggregate(node(u).child_[RIGHT]))))
+            throw logic_error("Wrong aggregate.");
+    }
+    return l_height + (node(u).color_ == BLACK);
+}
+
+// Cuts u off its parent, given u's black height, and blackens it if it's red.
+TEMPLATE
+typename ORDERED_SET::Subtree ORDERED_SET::detach(link u, int height) {
+    if (!u) return {};
+    node(u).parent_ = {};
+    if (node(u).color_ == RED) node(u).color_ = BLACK, height++;
+    return {u, height};
+}
+
+// Joins l, the node k and r, where everything in l is less than k and everything in r greater, in O(|l.height - r.height| + 1).
+// k hangs off the inner spine of the taller tree at a black node as high as the shorter tree, then insert_fix takes care of a red parent.
+TEMPLATE
+typename ORDERED_SET::Subtree ORDERED_SET::join(Subtree l, link k, Subtree r) {
+    node(k).parent_ = {};
+    if (l.height == r.height) {
+        node(k).child_[LEFT] = l.root;
+        node(k).child_[RIGHT] = r.root;
+        if (l.root) node(l.root).parent_ = k;
+        if (r.root) node(r.root).parent_ = k;
+        update_size(k, false);
+        node(k).color_ = BLACK;
+        return {k, l.height + 1};
+    }
     
-    // Sibling must exist, since if it's nullptr, its black depth is less than u's subtree.
-    // Nephews may not exist if erase_fix is called on the dummy node (first call)
+    Direction direction = l.height > r.height ? RIGHT : LEFT;
+    Subtree tall = direction == RIGHT ? l : r, low = direction == RIGHT ? r : l;
     
-    if (parent->color_ == BLACK && sibling->color_ == BLACK && (!close_nephew || close_nephew->color_ == BLACK) && (!distant_nephew || distant_nephew->color_ == BLACK)) {
-        // Go up.
-        sibling->color_ = RED;
-        return erase_fix(parent);
+    link parent = {}, u = tall.root;
+    int height = tall.height;
+    while (color(u) == RED || height > low.height) {
+        height -= color(u) == BLACK;
+        parent = u;
+        u = node(u).child_[direction];
     }
     
-    if (sibling->color_ == RED) {
-        // Now nephews must both exist and be black, rotate the parent to u's direction and swap its color with the (previously) sibling, then continue fixing from u.
-        swap(parent->color_, sibling->color_);
-        rotate(parent, direction);
-        sibling = close_nephew;
-        close_nephew = sibling->child_[direction].get();
-        distant_nephew = sibling->child_[!direction].get();
-        // close nephew is now the sibling, so sibling is black.
-    }
+    node(k).child_[!direction] = u;
+    node(k).child_[direction] = low.root;
+    if (u) node(u).parent_ = k;
+    if (low.root) node(low.root).parent_ = k;
+    update_size(k, false);
+    node(k).color_ = RED;
+    node(parent).child_[direction] = k;
+    node(k).parent_ = parent;
     
-    // u and sibling are black. at least one of the involved nodes is red
+    root_ = tall.root;
+    update_size(parent);
+    bool grown = insert_fix(k);
+    return {root_, tall.height + grown};
+}
+
+// Joins l and r, where everything in l is less than everything in r, using the greatest node of l as the middle.
+TEMPLATE
+typename ORDERED_SET::Subtree ORDERED_SET::join(Subtree l, Subtree r) {
+    if (!l.root) return r;
+    if (!r.root) return l;
+    auto [rest, last] = split_last(l);
+    return join(rest, last, r);
+}
+
+// Splits t into the elements less than key and the ones greater than it, and returns the node equal to key (if any) apart from both.
+TEMPLATE
+tuple<typename ORDERED_SET::Subtree, typename ORDERED_SET::link, typename ORDERED_SET::Subtree> ORDERED_SET::split(Subtree t, const T &key) {
+    link u = t.root;
+    if (!u) return {};
+    Subtree l = detach(node(u).child_[LEFT], t.height - 1), r = detach(node(u).child_[RIGHT], t.height - 1);
     
-    if ((!close_nephew || close_nephew->color_ == BLACK) && (!distant_nephew || distant_nephew->color_ == BLACK)) {
-        // parent is currently the only unchecked node, so it's red.
-        // push the sibling's black to the parent, now both subtrees have the same black depth.
-        swap(parent->color_, sibling->color_);
-        return;
+    if (equivalent(key, node(u).value_)) return {l, u, r};
+    if (compare(key, node(u).value_)) {
+        auto [ll, found, lr] = split(l, key);
+        return {ll, found, join(lr, u, r)};
     }
+    auto [rl, found, rr] = split(r, key);
+    return {join(l, u, rl), found, rr};
+}
+
+TEMPLATE
+pair<typename ORDERED_SET::Subtree, typename ORDERED_SET::Subtree> ORDERED_SET::split_by_order(Subtree t, size_type k) {
+    link u = t.root;
+    if (!u) return {};
+    size_type l_size = subtree_size(node(u).child_[LEFT]);
+    Subtree l = detach(node(u).child_[LEFT], t.height - 1), r = detach(node(u).child_[RIGHT], t.height - 1);
     
-    // at least one nephew exists and is red, we need it to be the distant one for the final fix.
+    if (k <= l_size) {
+        auto [ll, lr] = split_by_order(l, k);
+        return {ll, join(lr, u, r)};
+    }
+    auto [rl, rr] = split_by_order(r, k - l_size - 1);
+    return {join(l, u, rl), rr};
+}
+
+// Splits the greatest node off a non-empty t.
+TEMPLATE
+pair<typename ORDERED_SET::Subtree, typename ORDERED_SET::link> ORDERED_SET::split_last(Subtree t) {
+    link u = t.root;
+    Subtree l = detach(node(u).child_[LEFT], t.height - 1), r = detach(node(u).child_[RIGHT], t.height - 1);
+    if (!r.root) return {l, u};
+    auto [rest, last] = split_last(r);
+    return {join(l, u, rest), last};
+}
+
+
+// Set Operations
+// Each one splits the other tree by the root of one tree, recurses on both sides and joins the results, taking O(m * log(n / m + 1)) for sizes m <= n.
+// The other set ends up empty, and when the sets don't share a node pool, other's elements are moved to this set's pool first, in O(size of other).
+// This set's nodes stay where they are, so iterators to its elements stay valid unless the operation erases them.
+
+// Adds the elements of other to this set.
+TEMPLATE
+void ORDERED_SET::unite(ordered_set &&other) {
+    static_assert(!MULTI, "Set operations need unique elements.");
+    tally(&ordered_set_stats::bulk_operations);
+    share_pool(other);
+    root_ = unite({root_, black_height(root_)}, {other.root_, black_height(other.root_)}).root;
+    other.root_ = {};
+}
+
+// Keeps only the elements that are also in other.
+TEMPLATE
+void ORDERED_SET::intersect(ordered_set &&other) {
+    static_assert(!MULTI, "Set operations need unique elements.");
+    tally(&ordered_set_stats::bulk_operations);
+    share_pool(other);
+    root_ = intersect({root_, black_height(root_)}, {other.root_, black_height(other.root_)}).root;
+    other.root_ = {};
+}
+
+// Erases the elements that are in other.
+TEMPLATE
+void ORDERED_SET::subtract(ordered_set &&other) {
+    static_assert(!MULTI, "Set operations need unique elements.");
+    tally(&ordered_set_stats::bulk_operations);
+    share_pool(other);
+    root_ = subtract({root_, black_height(root_)}, {other.root_, black_height(other.root_)}).root;
+    other.root_ = {};
+}
+
+TEMPLATE
+typename ORDERED_SET::Subtree ORDERED_SET::unite(Subtree a, Subtree b) {
+    if (!a.root) return b;
+    if (!b.root) return a;
+    link u = a.root;
+    Subtree al = detach(node(u).child_[LEFT], a.height - 1), ar = detach(node(u).child_[RIGHT], a.height - 1);
+    auto [bl, found, br] = split(b, node(u).value_);
+    if (found) pool_->deallocate(found);
+    Subtree l = unite(al, bl), r = unite(ar, br);
+    return join(l, u, r);
+}
+
+TEMPLATE
+typename ORDERED_SET::Subtree ORDERED_SET::intersect(Subtree a, Subtree b) {
+    if (!a.root || !b.root) {
+        free_subtree(a.root);
+        free_subtree(b.root);
+        return {};
+    }
+    link u = a.root;
+    Subtree al = detach(node(u).child_[LEFT], a.height - 1), ar = detach(node(u).child_[RIGHT], a.height - 1);
+    auto [bl, found, br] = split(b, node(u).value_);
+    Subtree l = intersect(al, bl), r = intersect(ar, br);
+    if (found) {
+        pool_->deallocate(found);
+        return join(l, u, r);
+    }
+    pool_->deallocate(u);
+    return join(l, r);
+}
+
+TEMPLATE
+typename ORDERED_SET::Subtree ORDERED_SET::subtract(Subtree a, Subtree b) {
+    if (!a.root || !b.root) {
+        free_subtree(b.root);
+        return a;
+    }
+    link u = b.root;
+    Subtree bl = detach(node(u).child_[LEFT], b.height - 1), br = detach(node(u).child_[RIGHT], b.height - 1);
+    auto [al, found, ar] = split(a, node(u).value_);
+    if (found) pool_->deallocate(found);
+    pool_->deallocate(u);
+    return join(subtract(al, bl), subtract(ar, br));
+}
+
+// Makes both sets allocate from the same pool, moving the elements of other over to this set's pool if they don't already.
+// This set's nodes never move, so its iterators stay valid, while other is about to be emptied by the caller anyway.
+TEMPLATE
+void ORDERED_SET::share_pool(ordered_set &other) {
+    if (pool_ == other.pool_) return;
+    if (!pool_ || !other.pool_) {
+        pool_ = other.pool_ = pool_ ? pool_ : other.pool_;
+        return;
+    }
+    vector<T> values;
+    values.reserve(other.size());
+    for (Iterator it = other.begin(); it != other.end(); ++it) values.push_back(std::move(other.node(it.ptr_).value_));
+    other.clear();
+    other.pool_ = pool_;
+    other.merge_sorted(make_move_iterator(values.begin()), make_move_iterator(values.end()));
+}
+
+
+// Parallel Operations
+// The trees are flattened into arrays of nodes by order, the arrays are sorted, merged and filtered in chunks on separate threads,
+// and the balanced tree is linked back over them with its top levels built on separate threads, taking O((n + m) / threads) for the linear steps.
+// Only allocating and freeing nodes stay on the calling thread, as the node pool isn't thread-safe.
+// threads = 0 uses every hardware thread, and each thread gets at least PARALLEL_GRAIN elements. The set must not be used by other threads meanwhile.
+
+// Inserts every element in [first, last) like insert(first, last), which it falls back to when there is work for one thread only.
+// Otherwise the new nodes are sorted in parallel and merged with the set's.
+TEMPLATE
+template<typename InputIt>
+void ORDERED_SET::parallel_insert(InputIt first, InputIt last, int threads) {
+    vector<T> values(first, last);
+    int tasks = task_count(threads, size() + values.size());
+    if (tasks == 1) return insert(make_move_iterator(values.begin()), make_move_iterator(values.end()));
+    tally(&ordered_set_stats::bulk_operations);
     
-    if (!distant_nephew || distant_nephew->color_ == BLACK) {
-        // close nephew is the red one, some rotations and changing colors will do.
-        swap(sibling->color_, close_nephew->color_);
-        rotate(sibling, !direction);
-        sibling = close_nephew;
-        close_nephew = sibling->child_[direction].get();
-        distant_nephew = sibling->child_[!direction].get();
-        // Now sibling is still black, but distant nephew is red.
+    vector<link> nodes(values.size());
+    for (size_t i = 0; i < values.size(); i++) nodes[i] = pool().allocate(std::move(values[i]));
+    sort_links(nodes, tasks);
+    vector<link> existing = links(tasks), merged(existing.size() + nodes.size());
+    fork_join(tasks, [&](int t) { merge_links(existing.data(), existing.size(), nodes.data(), nodes.size(), merged.data(), t, tasks); });
+    if constexpr (!MULTI) merged = compact_links(merged, [&](size_t i) { return i == 0 || !equivalent(node(merged[i - 1]).value_, node(merged[i]).value_); }, tasks);
+    assemble(merged, tasks);
+}
+
+// unite in parallel, in O((n + m) / threads) however different the sizes are, so it only pays off for sets of similar size.
+TEMPLATE
+void ORDERED_SET::parallel_unite(ordered_set &&other, int threads) {
+    static_assert(!MULTI, "Set operations need unique elements.");
+    tally(&ordered_set_stats::bulk_operations);
+    share_pool(other);
+    int tasks = task_count(threads, size() + other.size());
+    vector<link> a = links(tasks), b = other.links(tasks), merged(a.size() + b.size());
+    other.root_ = {};
+    fork_join(tasks, [&](int t) { merge_links(a.data(), a.size(), b.data(), b.size(), merged.data(), t, tasks); });
+    // Equal elements end up side by side, this set's first.
+    merged = compact_links(merged, [&](size_t i) { return i == 0 || !equivalent(node(merged[i - 1]).value_, node(merged[i]).value_); }, tasks);
+    assemble(merged, tasks);
+}
+
+// intersect in parallel, in O((n + m) / threads).
+TEMPLATE
+void ORDERED_SET::parallel_intersect(ordered_set &&other, int threads) {
+    static_assert(!MULTI, "Set operations need unique elements.");
+    tally(&ordered_set_stats::bulk_operations);
+    share_pool(other);
+    int tasks = task_count(threads, size() + other.size());
+    vector<link> a = links(tasks), b = other.links(tasks), merged(a.size() + b.size());
+    other.root_ = {};
+    fork_join(tasks, [&](int t) { merge_links(a.data(), a.size(), b.data(), b.size(), merged.data(), t, tasks); });
+    size_t n = merged.size();
+    merged = compact_links(merged, [&](size_t i) { return i + 1 < n && equivalent(node(merged[i]).value_, node(merged[i + 1]).value_); }, tasks);
+    assemble(merged, tasks);
+}
+
+// Calls f on every element in [first, last), splitting the range by order among threads, each of which finds its first element with find_by_order and steps from there.
+// f is called concurrently on different elements, so it must be safe to.
+TEMPLATE
+template<typename F>
+void ORDERED_SET::parallel_for_each(Iterator first, Iterator last, F f, int threads) const {
+    tally(&ordered_set_stats::bulk_operations);
+    size_type lo = first.order(), hi = last.order();
+    if (lo > hi) throw invalid_argument("Range must not end before it starts.");
+    walk(lo, hi, task_count(threads, hi - lo), [&](size_type, link u) { f(as_const(node(u).value_)); });
+}
+
+// The number of threads to split work over: threads (every hardware thread if 0), but at most one per PARALLEL_GRAIN elements.
+TEMPLATE
+int ORDERED_SET::task_count(int threads, size_t work) {
+    if (threads <= 0) threads = int(max(1u, thread::hardware_concurrency()));
+    return int(clamp(work / PARALLEL_GRAIN, size_t(1), size_t(threads)));
+}
+
+// Runs f(0), ..., f(tasks - 1) on their own threads, f(0) on the calling one, and waits for all of them, rethrowing the first exception any of them threw.
+TEMPLATE
+template<typename F>
+void ORDERED_SET::fork_join(int tasks, F f) {
+    vector<exception_ptr> errors(tasks);
+    auto run = [&](int t) {
+        try {
+            f(t);
+        } catch (...) {
+            errors[t] = current_exception();
+        }
+    };
+    vector<thread> workers;
+    workers.reserve(tasks - 1);
+    for (int t = 1; t < tasks; t++) workers.emplace_back(run, t);
+    run(0);
+    for (thread &worker: workers) worker.join();
+    for (exception_ptr &error: errors) if (error) rethrow_exception(error);
+}
+
+// Calls f(k, u) for the node u of every order k in [lo, hi), splitting the orders into tasks chunks walked side by side.
+TEMPLATE
+template<typename F>
+void ORDERED_SET::walk(size_type lo, size_type hi, int tasks, F f) const {
+    fork_join(tasks, [&](int t) {
+        size_type first = lo + (hi - lo) * t / tasks, last = lo + (hi - lo) * (t + 1) / tasks;
+        link u = first < last ? find_by_order(first).ptr_ : link();
+        for (size_type k = first; k < last; k++, u = neighbor(u, RIGHT)) f(k, u);
+    });
+}
+
+// Returns the nodes in order.
+TEMPLATE
+vector<typename ORDERED_SET::link> ORDERED_SET::links(int tasks) const {
+    vector<link> nodes(size());
+    walk(0, size(), tasks, [&](size_type k, link u) { nodes[k] = u; });
+    return nodes;
+}
+
+// Stably sorts nodes by value: tasks chunks are sorted side by side, then merged in pairs, all the threads sharing each round of merges.
+TEMPLATE
+void ORDERED_SET::sort_links(vector<link> &nodes, int tasks) const {
+    size_t n = nodes.size();
+    auto bound = [&](int t) { return n * t / tasks; };
+    fork_join(tasks, [&](int t) {
+        stable_sort(nodes.begin() + bound(t), nodes.begin() + bound(t + 1), [this](link u, link v) { return compare(node(u).value_, node(v).value_); });
+    });
+    vector<link> buffer(n);
+    for (int width = 1; width < tasks; width *= 2) {
+        fork_join(tasks, [&](int t) {
+            int first = t - t % (2 * width), parts = min(2 * width, tasks - first);
+            size_t lo = bound(first), mid = bound(min(first + width, tasks)), hi = bound(first + parts);
+            merge_links(nodes.data() + lo, mid - lo, nodes.data() + mid, hi - mid, buffer.data() + lo, t - first, parts);
+        });
+        nodes.swap(buffer);
     }
+}
+
+// Writes the part-th of parts pieces of the merge of the sorted a and b to out, pieces starting at equal shares of the longer input.
+// Nodes of a go before equal nodes of b, so merging is stable.
+TEMPLATE
+void ORDERED_SET::merge_links(const link *a, size_type na, const link *b, size_type nb, link *out, int part, int parts) const {
+    auto less = [this](link u, link v) { return compare(node(u).value_, node(v).value_); };
+    auto cut = [&](int i) -> pair<size_type, size_type> {
+        if (i == 0) return {0, 0};
+        if (i == parts) return {na, nb};
+        if (na >= nb) {
+            size_type j = na * i / parts;
+            return {j, j == na ? nb : size_type(std::lower_bound(b, b + nb, a[j], less) - b)};
+        }
+        size_type j = nb * i / parts;
+        return {size_type(std::upper_bound(a, a + na, b[j], less) - a), j};
+    };
+    auto [a_lo, b_lo] = cut(part);
+    auto [a_hi, b_hi] = cut(part + 1);
+    std::merge(a + a_lo, a + a_hi, b + b_lo, b + b_hi, out + a_lo + b_lo, less);
+}
+
+// Returns the nodes i for which keep(i) holds, in order, and frees the others.
+TEMPLATE
+template<typename Keep>
+vector<typename ORDERED_SET::link> ORDERED_SET::compact_links(const vector<link> &nodes, Keep keep, int tasks) {
+    size_t n = nodes.size();
+    auto bound = [&](int t) { return n * t / tasks; };
+    vector<char> kept(n);
+    vector<size_t> offsets(tasks + 1);
+    fork_join(tasks, [&](int t) {
+        for (size_t i = bound(t); i < bound(t + 1); i++) offsets[t + 1] += kept[i] = keep(i);
+    });
+    partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    vector<link> result(offsets[tasks]);
+    fork_join(tasks, [&](int t) {
+        size_t j = offsets[t];
+        for (size_t i = bound(t); i < bound(t + 1); i++) if (kept[i]) result[j++] = nodes[i];
+    });
+    for (size_t i = 0; i < n; i++) if (!kept[i]) pool_->deallocate(nodes[i]);
+    return result;
+}
+
+// Links the n nodes, which are in order, into a perfectly balanced subtree colored like the one build makes out of a vine.
+// The two halves are built on separate threads while there are tasks to spare.
+TEMPLATE
+typename ORDERED_SET::link ORDERED_SET::build(const link *nodes, size_type n, int depth, int red_depth, int tasks) {
+    if (!n) return {};
     
-    // Parent's color is x, sibling is black, distant nephew is red, close nephew's color doesn't matter.
-    // u's subtree needs to pass through an extra black node to the root.
-    distant_nephew->color_ = BLACK;
-    swap(parent->color_, sibling->color_);
-    rotate(parent, direction);
-    // close nephew's subtree passes through the same nodes (parent and sibling with black and x colors), no changes in black depth.
-    // Distant nephew's subtree passes through the black added to distant nephew instead of the sibling's black (swapped to parent), no changes in black depth.
-    // u's subtree passes through an extra black from the sibling, fixed.
+    size_type l_size = (n - 1) / 2;
+    link u = nodes[l_size], left, right;
+    if (tasks > 1) {
+        thread worker([&] { left = build(nodes, l_size, depth + 1, red_depth, tasks / 2); });
+        right = build(nodes + l_size + 1, n - 1 - l_size, depth + 1, red_depth, tasks - tasks / 2);
+        worker.join();
+    } else {
+        left = build(nodes, l_size, depth + 1, red_depth, 1);
+        right = build(nodes + l_size + 1, n - 1 - l_size, depth + 1, red_depth, 1);
+    }
     
+    node(u).child_[LEFT] = left;
+    node(u).child_[RIGHT] = right;
+    if (left) node(left).parent_ = u;
+    if (right) node(right).parent_ = u;
+    update_size(u, false);
+    node(u).color_ = depth && depth == red_depth ? RED : BLACK;
+    return u;
+}
+
+// Replaces the tree with the balanced tree over nodes, which are in order.
+TEMPLATE
+void ORDERED_SET::assemble(const vector<link> &nodes, int tasks) {
+    size_type n = nodes.size();
+    root_ = build(nodes.data(), n, 0, int(bit_width(n)) - 1, tasks);
+    if (root_) node(root_).parent_ = {};
 }
 
 
 // Node Functions
 
-template<typename T>
-void ordered_set<T>::add_child(Node *u, Node *child, Direction direction) {
-    assert(!u->child_[direction]);
-    u->child_[direction].reset(child);
-    child->parent_ = u;
+// Adds n to a counter when the policy keeps stats.
+TEMPLATE
+void ORDERED_SET::tally(uint64_t ordered_set_stats::*counter, uint64_t n) const {
+    if constexpr (STATS) atomic_ref(stats_.*counter).fetch_add(n, memory_order_relaxed);
+}
+
+// Counts a descent that visited depth nodes.
+TEMPLATE
+void ORDERED_SET::tally_descent(int depth) const {
+    if constexpr (STATS) {
+        tally(&ordered_set_stats::descents);
+        tally(&ordered_set_stats::descent_depth, depth);
+        atomic_ref max_depth(stats_.max_descent_depth);
+        uint64_t max = max_depth.load(memory_order_relaxed);
+        while (max < uint64_t(depth) && !max_depth.compare_exchange_weak(max, depth, memory_order_relaxed)) {}
+    }
+}
+
+// comp_, counted. Every comparison of elements goes through here.
+TEMPLATE
+template<typename A, typename B>
+bool ORDERED_SET::compare(const A &a, const B &b) const {
+    tally(&ordered_set_stats::comparisons);
+    return comp_(a, b);
+}
+
+// compare as a function object, for the standard algorithms.
+TEMPLATE
+auto ORDERED_SET::comparator() const { return [this](const auto &a, const auto &b) { return compare(a, b); }; }
+
+// Elements are equal when neither is less than the other under comp_.
+TEMPLATE
+template<typename A, typename B>
+bool ORDERED_SET::equivalent(const A &a, const B &b) const { return !compare(a, b) && !compare(b, a); }
+
+// Returns the node equal to key, if any.
+TEMPLATE
+template<typename K>
+typename ORDERED_SET::link ORDERED_SET::locate(const K &key) const {
+    link u = bound(key, false);
+    return u && !compare(key, node(u).value_) ? u : link();
+}
+
+// Returns the least node not less than key (greater than key if strict), one comparison per level.
+TEMPLATE
+template<typename K>
+typename ORDERED_SET::link ORDERED_SET::bound(const K &key, bool strict) const {
+    link u = root_, ret = {};
+    int depth = 0;
+    for (; u; depth++) {
+        if (strict ? compare(key, node(u).value_) : !compare(node(u).value_, key)) ret = u, u = node(u).child_[LEFT];
+        else u = node(u).child_[RIGHT];
+    }
+    tally_descent(depth);
+    return ret;
+}
+
+// Returns the number of elements less than key (not greater than key if strict).
+TEMPLATE
+template<typename K>
+typename ORDERED_SET::size_type ORDERED_SET::rank(const K &key, bool strict) const {
+    link u = root_;
+    size_type order = 0;
+    int depth = 0;
+    for (; u; depth++) {
+        if (strict ? !compare(key, node(u).value_) : compare(node(u).value_, key)) {
+            order += subtree_size(node(u).child_[LEFT]) + 1;
+            u = node(u).child_[RIGHT];
+        } else {
+            u = node(u).child_[LEFT];
+        }
+    }
+    tally_descent(depth);
+    return order;
+}
+
+// Returns the topmost node in [lo, hi), where the paths to lo and hi part, or null if the range is empty.
+TEMPLATE
+typename ORDERED_SET::link ORDERED_SET::range_top(const T &lo, const T &hi) const {
+    link u = root_;
+    while (u) {
+        if (compare(node(u).value_, lo)) u = node(u).child_[RIGHT];
+        else if (!compare(node(u).value_, hi)) u = node(u).child_[LEFT];
+        else break;
+    }
+    return u;
+}
+
+// Returns the number of elements not less than lo in u's left subtree and less than hi in its right subtree.
+// The two walks are interleaved level by level, so that their cache misses overlap instead of adding up.
+TEMPLATE
+pair<typename ORDERED_SET::size_type, typename ORDERED_SET::size_type> ORDERED_SET::count_sides(link u, const T &lo, const T &hi) const {
+    link l = node(u).child_[LEFT], r = node(u).child_[RIGHT];
+    size_type l_count = 0, r_count = 0;
+    while (l && r) {
+        if (compare(node(l).value_, lo)) {
+            l = node(l).child_[RIGHT];
+        } else {
+            l_count += subtree_size(l);
+            l = node(l).child_[LEFT];
+            l_count -= subtree_size(l);
+        }
+        if (compare(node(r).value_, hi)) {
+            r_count += subtree_size(r);
+            r = node(r).child_[RIGHT];
+            r_count -= subtree_size(r);
+        } else {
+            r = node(r).child_[LEFT];
+        }
+    }
+    return {l_count + count_at_least(l, lo), r_count + count_less(r, hi)};
+}
+
+// Returns the number of elements in u's subtree not less than lo.
+// What a node adds is its size minus that of the child the walk goes on to, so unlike rank it reads no node off the path.
+TEMPLATE
+typename ORDERED_SET::size_type ORDERED_SET::count_at_least(link u, const T &lo) const {
+    size_type count = 0;
+    while (u) {
+        if (compare(node(u).value_, lo)) {
+            u = node(u).child_[RIGHT];
+        } else {
+            count += subtree_size(u);
+            u = node(u).child_[LEFT];
+            count -= subtree_size(u);
+        }
+    }
+    return count;
+}
+
+// Returns the number of elements in u's subtree less than hi, the same way.
+TEMPLATE
+typename ORDERED_SET::size_type ORDERED_SET::count_less(link u, const T &hi) const {
+    size_type count = 0;
+    while (u) {
+        if (compare(node(u).value_, hi)) {
+            count += subtree_size(u);
+            u = node(u).child_[RIGHT];
+            count -= subtree_size(u);
+        } else {
+            u = node(u).child_[LEFT];
+        }
+    }
+    return count;
+}
+
+// Returns the (k+1)-th least node of u's subtree, which must have more than k elements, by sizes alone.
+TEMPLATE
+typename ORDERED_SET::link ORDERED_SET::select(link u, size_type k) const {
+    while (true) {
+        size_type l_size = subtree_size(node(u).child_[LEFT]);
+        if (l_size == k) return u;
+        if (l_size > k) {
+            u = node(u).child_[LEFT];
+        } else {
+            k -= l_size + 1;
+            u = node(u).child_[RIGHT];
+        }
+    }
+}
+
+TEMPLATE
+typename ORDERED_SET::pool_type &ORDERED_SET::pool() {
+    if (!pool_) pool_ = make_shared<pool_type>();
+    return *pool_;
+}
+
+TEMPLATE
+typename ORDERED_SET::Node &ORDERED_SET::node(link u) const { return pool_->at(u); }
+
+// Missing children count as black leaves of size 0.
+TEMPLATE
+typename ORDERED_SET::size_type ORDERED_SET::subtree_size(link u) const { return u ? size_type(node(u).size_) : 0; }
+
+TEMPLATE
+typename ORDERED_SET::aggregate_type ORDERED_SET::aggregate(link u) const { return u ? node(u).aggregate_ : augmentation::identity(); }
+
+TEMPLATE
+Color ORDERED_SET::color(link u) const { return u ? node(u).color_ : BLACK; }
+
+TEMPLATE
+void ORDERED_SET::swap_colors(link u, link v) {
+    Color color = node(u).color_;
+    node(u).color_ = node(v).color_;
+    node(v).color_ = color;
+}
+
+TEMPLATE
+void ORDERED_SET::add_child(link u, link child, Direction direction) {
+    assert(!node(u).child_[direction]);
+    node(u).child_[direction] = child;
+    node(child).parent_ = u;
+}
+
+// Recomputes u's size and aggregate from its children, and then its ancestors' if recursive.
+TEMPLATE
+void ORDERED_SET::update_size(link u, bool recursive) {
+    for (; u; u = node(u).parent_) {
+        node(u).size_ = 1 + subtree_size(node(u).child_[LEFT]) + subtree_size(node(u).child_[RIGHT]);
+        if constexpr (AUGMENTED) node(u).aggregate_ = augmentation::combine(augmentation::combine(aggregate(node(u).child_[LEFT]), augmentation::lift(node(u).value_)), aggregate(node(u).child_[RIGHT]));
+        if (!recursive) return;
+    }
+}
+
+// Adds delta to the sizes of u and its ancestors, after a single node was linked in or cut out below u.
+// Cheaper than update_size, which reads both children at every level. Aggregates can't be patched like that, so augmented trees recompute.
+TEMPLATE
+void ORDERED_SET::add_size(link u, int delta) {
+    if constexpr (AUGMENTED) return update_size(u);
+    for (; u; u = node(u).parent_) node(u).size_ += delta;
+}
+
+// Adds delta to the sizes of u and its ancestors up to stop (excluded), for the top-down passes, which count the node they will link in or cut out as they go.
+// Augmented trees recompute on the way back up instead, so it does nothing for them.
+TEMPLATE
+void ORDERED_SET::add_path_size(link u, link stop, int delta) {
+    if constexpr (!AUGMENTED) for (; u != stop; u = node(u).parent_) node(u).size_ += delta;
+}
+
+TEMPLATE
+Direction ORDERED_SET::get_direction(link u) const {
+    assert(node(u).parent_);
+    return node(node(u).parent_).child_[RIGHT] == u ? RIGHT : LEFT;
+}
+
+// Returns the number of elements less than u's, counting left subtrees on the way up, without comparing any keys.
+TEMPLATE
+typename ORDERED_SET::size_type ORDERED_SET::order_of(link u) const {
+    if (!u) return size();
+    size_type order = subtree_size(node(u).child_[LEFT]);
+    for (link p = node(u).parent_; p; u = p, p = node(p).parent_)
+        if (node(p).child_[RIGHT] == u) order += subtree_size(node(p).child_[LEFT]) + 1;
+    return order;
+}
+
+// Returns the in-order neighbor of u in the given direction, or the null link if there is none.
+// The neighbor of the past-the-end position (the null link) to the left is the greatest node.
+TEMPLATE
+typename ORDERED_SET::link ORDERED_SET::neighbor(link u, Direction direction) const {
+    if (!u) {
+        if (direction == RIGHT) return {};
+        for (u = root_; u && node(u).child_[RIGHT];) u = node(u).child_[RIGHT];
+        return u;
+    }
+    if (node(u).child_[direction]) {
+        u = node(u).child_[direction];
+        while (node(u).child_[!direction]) u = node(u).child_[!direction];
+        return u;
+    }
+    // Climb while coming from the side of direction, comparing with the child we came from instead of looking up our own side.
+    link p = node(u).parent_;
+    while (p && node(p).child_[direction] == u) u = p, p = node(p).parent_;
+    return p;
 }
 
-template<typename T>
-void ordered_set<T>::update_size(Node *u, bool recursive) {
-    if (!u) return;
-    u->size_ = 1;
-    for (auto &c: u->child_.data) if (c) u->size_ += c->size_;
-    if (recursive) update_size(u->parent_);
+// Exchanges the places of u and its successor v, which lies in u's right subtree and has no left child, so that erasing u doesn't have to move values.
+// Colors and sizes stay with the places, aggregates along v's old path are stale until the erase updates them.
+TEMPLATE
+void ORDERED_SET::swap_with_successor(link u, link v) {
+    link parent = node(u).parent_, v_parent = node(v).parent_;
+    link left = node(u).child_[LEFT], right = node(u).child_[RIGHT], v_right = node(v).child_[RIGHT];
+    
+    (parent ? node(parent).child_[get_direction(u)] : root_) = v;
+    node(v).parent_ = parent;
+    node(v).child_[LEFT] = left;
+    node(left).parent_ = v;
+    if (v == right) {
+        node(v).child_[RIGHT] = u;
+        node(u).parent_ = v;
+    } else {
+        node(v).child_[RIGHT] = right;
+        node(right).parent_ = v;
+        node(v_parent).child_[LEFT] = u;
+        node(u).parent_ = v_parent;
+    }
+    node(u).child_[LEFT] = {};
+    node(u).child_[RIGHT] = v_right;
+    if (v_right) node(v_right).parent_ = u;
+    
+    swap_colors(u, v);
+    size_type size = node(u).size_;
+    node(u).size_ = node(v).size_;
+    node(v).size_ = size;
 }
 
-template<typename T>
-Direction ordered_set<T>::get_direction(Node *u) {
-    assert(u->parent_);
-    return u->parent_->child_[RIGHT].get() == u ? RIGHT : LEFT;
+// Visits nodes in order until last (or the end), given a stack of the nodes to come, each above the next, the first one on top.
+// Visiting a node pushes the left spine of its right subtree, so every node is read once on the way down and never again.
+// The next node is already read by then, so the right child it leads to is prefetched while f runs.
+TEMPLATE
+template<typename F>
+void ORDERED_SET::scan(link *stack, int top, link last, F &f) const {
+    while (top) {
+        link u = stack[--top];
+        if (u == last) return;
+        for (link v = node(u).child_[RIGHT]; v; v = node(v).child_[LEFT]) stack[top++] = v;
+        if (top && node(stack[top - 1]).child_[RIGHT]) __builtin_prefetch(&node(node(stack[top - 1]).child_[RIGHT]));
+        f(as_const(node(u).value_));
+    }
 }
 
-template<typename T>
-void ordered_set<T>::rotate(Node *u, Direction direction) {
+// Returns the node n positions after u (before it if n is negative), or the null link for the past-the-end position.
+// Climbs only until the target falls inside the current subtree, so short hops stay near u instead of restarting from the root.
+TEMPLATE
+typename ORDERED_SET::link ORDERED_SET::advance(link u, difference_type n) const {
+    if (!u) return find_by_order(size() + n).ptr_;
     
-    Direction u_direction;
+    // k is the target's order within u's subtree.
+    difference_type k = difference_type(subtree_size(node(u).child_[LEFT])) + n;
+    while (k < 0 || k >= difference_type(node(u).size_)) {
+        link p = node(u).parent_;
+        if (!p) {
+            if (k == difference_type(node(u).size_)) return {};
+            throw out_of_range("Order out of range.");
+        }
+        if (node(p).child_[RIGHT] == u) k += difference_type(subtree_size(node(p).child_[LEFT])) + 1;
+        u = p;
+    }
     
-    // Create pointers to parent, child, and inner grandchild, while releasing unique_ptrs from u, child, and inner grandchild.
-    Node *parent = u->parent_;
-    if (parent) parent->child_[u_direction = get_direction(u)].release(); else root_.release();
-    Node *child = u->child_[!direction].release();
-    Node *grandchild = child->child_[direction].release();
+    while (true) {
+        difference_type l_size = subtree_size(node(u).child_[LEFT]);
+        if (l_size == k) return u;
+        if (l_size > k) {
+            u = node(u).child_[LEFT];
+        } else {
+            k -= l_size + 1;
+            u = node(u).child_[RIGHT];
+        }
+    }
+}
+
+TEMPLATE
+void ORDERED_SET::rotate(link u, Direction direction) {
+    tally(&ordered_set_stats::rotations);
     
-    // Reattach unique_ptrs to u, -previously- child, and inner grandchild
-    add_child(child, u, direction);
-    if (parent) add_child(parent, child, u_direction); else root_.reset(child), child->parent_ = nullptr;
-    if (grandchild) add_child(u, grandchild, !direction);
+    link parent = node(u).parent_;
+    link child = node(u).child_[!direction];
+    link grandchild = node(child).child_[direction];
+    
+    // Child takes u's place under parent, u becomes its child, and the inner grandchild moves over to u.
+    (parent ? node(parent).child_[get_direction(u)] : root_) = child;
+    node(child).parent_ = parent;
+    node(u).child_[!direction] = grandchild;
+    if (grandchild) node(grandchild).parent_ = u;
+    node(child).child_[direction] = u;
+    node(u).parent_ = child;
     
     // Non-recursively update the sizes of the 2 nodes involved in the rotation, no other node sizes are affected.
     update_size(u, false);
@@ -384,63 +1930,50 @@ void ordered_set<T>::rotate(Node *u, Direction direction) {
 
 // Iterator Functions
 
-template<typename T>
-ordered_set<T>::Iterator::Iterator(const ordered_set *tree, Node *ptr):tree_(tree), ptr_(ptr) {}
+TEMPLATE
+ORDERED_SET::Iterator::Iterator(const ordered_set *tree, link ptr):tree_(tree), ptr_(ptr) {}
 
-template<typename T>
-const T &ordered_set<T>::Iterator::operator*() {
+TEMPLATE
+const T &ORDERED_SET::Iterator::operator*() {
     if (!ptr_) throw out_of_range("Dereferencing end iterator.");
-    return ptr_->value_;
+    return tree_->node(ptr_).value_;
 }
 
-template<typename T>
-T const *ordered_set<T>::Iterator::operator->() {
+TEMPLATE
+T const *ORDERED_SET::Iterator::operator->() {
     if (!ptr_) throw out_of_range("Dereferencing end iterator.");
-    return &ptr_->value_;
+    return &tree_->node(ptr_).value_;
 }
 
-template<typename T>
-iterator &ordered_set<T>::Iterator::operator++() {
+TEMPLATE
+iterator &ORDERED_SET::Iterator::operator++() {
     
     if (!ptr_) throw out_of_range("Incrementing end iterator.");
     
-    if (ptr_->child_[RIGHT]) {
-        ptr_ = ptr_->child_[RIGHT].get();
-        while (ptr_->child_[LEFT]) ptr_ = ptr_->child_[LEFT].get();
-    } else {
-        while (ptr_->parent_ && get_direction(ptr_) == RIGHT) ptr_ = ptr_->parent_;
-        ptr_ = ptr_->parent_; // In case of nullptr, it means no element is greater than current element, so it becomes an end iterator.
-    }
-    
+    // The null link past the greatest element is the end iterator.
+    ptr_ = tree_->neighbor(ptr_, RIGHT);
     return *this;
 }
 
-template<typename T>
-iterator ordered_set<T>::Iterator::operator++(int) {
+TEMPLATE
+iterator ORDERED_SET::Iterator::operator++(int) {
     Iterator tmp(*this);
     ++(*this);
     return tmp;
 }
 
-template<typename T>
-iterator &ordered_set<T>::Iterator::operator--() {
-    
-    if (!ptr_) {
-        *this = tree_->find_by_order(tree_->size() - 1);
-    } else if (ptr_->child_[LEFT]) {
-        ptr_ = ptr_->child_[LEFT].get();
-        while (ptr_->child_[RIGHT]) ptr_ = ptr_->child_[RIGHT].get();
-    } else {
-        while (ptr_->parent_ && get_direction(ptr_) == LEFT) ptr_ = ptr_->parent_;
-        ptr_ = ptr_->parent_; // In case of nullptr, it means no element is smaller than current element, so it was a begin iterator.
-        if (!ptr_) throw out_of_range("Decrementing begin iterator.");
-    }
+TEMPLATE
+iterator &ORDERED_SET::Iterator::operator--() {
     
+    // From end() that's the greatest element, down the right spine without reading any sizes.
+    link prev = tree_->neighbor(ptr_, LEFT);
+    if (!prev) throw out_of_range("Decrementing begin iterator.");
+    ptr_ = prev;
     return *this;
 }
 
-template<typename T>
-iterator ordered_set<T>::Iterator::operator--(int) {
+TEMPLATE
+iterator ORDERED_SET::Iterator::operator--(int) {
     Iterator tmp(*this);
     --(*this);
     return tmp;
@@ -449,35 +1982,132 @@ iterator ordered_set<T>::Iterator::operator--(int) {
 
 // Random-Access Iterator
 
-template<typename T>
-iterator ordered_set<T>::Iterator::operator+(int n) { return *this = tree_->find_by_order(order() + n); }
+TEMPLATE
+iterator ORDERED_SET::Iterator::operator+(difference_type n) { return *this = Iterator(tree_, tree_->advance(ptr_, n)); }
+
+TEMPLATE
+inline iterator operator+(typename ORDERED_SET::difference_type n, iterator i) { return i + n; }
+
+TEMPLATE
+iterator ORDERED_SET::Iterator::operator-(difference_type n) { return *this = Iterator(tree_, tree_->advance(ptr_, -n)); }
 
-template<typename T>
-inline iterator operator+(int n, iterator i) { return i + n; }
+TEMPLATE
+typename ORDERED_SET::difference_type ORDERED_SET::Iterator::operator-(Iterator other) { return difference_type(order() - other.order()); }
 
-template<typename T>
-iterator ordered_set<T>::Iterator::operator-(int n) { return *this = tree_->find_by_order(order() - n); }
+TEMPLATE
+bool ORDERED_SET::Iterator::operator<(ordered_set::Iterator other) { return order() < other.order(); }
 
-template<typename T>
-int ordered_set<T>::Iterator::operator-(Iterator other) { return order() - other.order(); }
+TEMPLATE
+bool ORDERED_SET::Iterator::operator<=(ordered_set::Iterator other) { return order() <= other.order(); }
 
-template<typename T>
-bool ordered_set<T>::Iterator::operator<(ordered_set::Iterator other) { return order() < other.order(); }
+TEMPLATE
+bool ORDERED_SET::Iterator::operator==(const Iterator &other) const { return tree_ == other.tree_ && ptr_ == other.ptr_; }
 
-template<typename T>
-bool ordered_set<T>::Iterator::operator<=(ordered_set::Iterator other) { return order() <= other.order(); }
+TEMPLATE
+bool ORDERED_SET::Iterator::operator!=(const Iterator &other) const { return !(*this == other); }
 
-template<typename T>
-bool ordered_set<T>::Iterator::operator==(const Iterator &other) const { return tree_ == other.tree_ && ptr_ == other.ptr_; }
+TEMPLATE
+bool ORDERED_SET::Iterator::operator>=(ordered_set::Iterator other) { return order() >= other.order(); }
 
-template<typename T>
-bool ordered_set<T>::Iterator::operator!=(const Iterator &other) const { return !(*this == other); }
+TEMPLATE
+bool ORDERED_SET::Iterator::operator>(ordered_set::Iterator other) { return order() > other.order(); }
 
-template<typename T>
-bool ordered_set<T>::Iterator::operator>=(ordered_set::Iterator other) { return order() >= other.order(); }
+TEMPLATE
+typename ORDERED_SET::size_type ORDERED_SET::Iterator::order() { return tree_->order_of(ptr_); }
+
+
+// Node Pool
+
+#define NODE_POOL node_pool<Node, Link, Allocator>
+
+template<typename Node, typename Link, typename Allocator>
+NODE_POOL::node_pool(const Allocator &alloc) : alloc_(alloc) {}
+
+template<typename Node, typename Link, typename Allocator>
+NODE_POOL::node_pool(node_pool &&other) noexcept
+        : alloc_(std::move(other.alloc_)), slabs_(std::move(other.slabs_)), used_(exchange(other.used_, 0)), free_(exchange(other.free_, Link())) {
+    other.slabs_.clear();
+}
+
+template<typename Node, typename Link, typename Allocator>
+NODE_POOL &NODE_POOL::operator=(node_pool &&other) noexcept {
+    if (this != &other) {
+        release();
+        alloc_ = std::move(other.alloc_);
+        slabs_ = std::move(other.slabs_);
+        other.slabs_.clear();
+        used_ = exchange(other.used_, 0);
+        free_ = exchange(other.free_, Link());
+    }
+    return *this;
+}
+
+template<typename Node, typename Link, typename Allocator>
+NODE_POOL::~node_pool() { release(); }
+
+// Constructs a node from args in a recycled slot if there is one, otherwise in the next unused slot, starting a slab twice as large as the last one when it runs out.
+template<typename Node, typename Link, typename Allocator>
+template<typename... Args>
+Link NODE_POOL::allocate(Args &&... args) {
+    Link u = free_;
+    if (u) {
+        free_ = slot(u).next;
+    } else {
+        if (slabs_.empty() || used_ == slabs_.back().second) {
+            size_t capacity = FIRST_SLAB << slabs_.size();
+            if (2 * capacity - FIRST_SLAB > max_nodes()) throw length_error("Too many nodes for the node pool's indices.");
+            slabs_.emplace_back(traits::allocate(alloc_, capacity), capacity);
+            used_ = 0;
+        }
+        if constexpr (INDEXED) u = Link(slabs_.back().second - FIRST_SLAB + used_ + 1);
+        else u = &slabs_.back().first[used_].node;
+        used_++;
+    }
+    traits::construct(alloc_, &slot(u).node, std::forward<Args>(args)...);
+    return u;
+}
+
+// Destroys the node and pushes its slot onto the freelist.
+template<typename Node, typename Link, typename Allocator>
+void NODE_POOL::deallocate(Link u) {
+    traits::destroy(alloc_, &slot(u).node);
+    slot(u).next = free_;
+    free_ = u;
+}
+
+template<typename Node, typename Link, typename Allocator>
+Node &NODE_POOL::at(Link u) const { return slot(u).node; }
+
+template<typename Node, typename Link, typename Allocator>
+void NODE_POOL::release() {
+    for (auto [slab, capacity]: slabs_) traits::deallocate(alloc_, slab, capacity);
+    slabs_.clear();
+    used_ = 0;
+    free_ = {};
+}
+
+// Bytes taken by the slabs, whether their slots are in use or not.
+template<typename Node, typename Link, typename Allocator>
+size_t NODE_POOL::memory_usage() const {
+    size_t slots = slabs_.empty() ? 0 : (FIRST_SLAB << slabs_.size()) - FIRST_SLAB;
+    return slots * sizeof(Slot) + slabs_.capacity() * sizeof(slabs_[0]);
+}
+
+// Slab k holds FIRST_SLAB << k slots, so index i + FIRST_SLAB (i being 0-based) has its highest bit at k + log2(FIRST_SLAB).
+template<typename Node, typename Link, typename Allocator>
+typename NODE_POOL::Slot &NODE_POOL::slot(Link u) const {
+    if constexpr (INDEXED) {
+        size_t i = size_t(u) - 1 + FIRST_SLAB;
+        int k = bit_width(i) - bit_width(FIRST_SLAB);
+        return slabs_[k].first[i - (FIRST_SLAB << k)];
+    } else {
+        return *reinterpret_cast<Slot *>(u);
+    }
+}
 
-template<typename T>
-bool ordered_set<T>::Iterator::operator>(ordered_set::Iterator other) { return order() > other.order(); }
+#undef NODE_POOL
+#undef iterator
+#undef ORDERED_SET
+#undef TEMPLATE
 
-template<typename T>
-int ordered_set<T>::Iterator::order() { return ptr_ ? tree_->order_of_key(ptr_->value_) : tree_->size(); }
+#endif //ORDERED_SET_ORDERED_SET_CPP
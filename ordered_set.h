@@ -15,54 +15,381 @@ using Direction::LEFT;
 using Direction::RIGHT;
 inline Direction operator!(Direction direction) { return direction == LEFT ? RIGHT : LEFT; }
 
-enum class Color {
+enum class Color : bool {
     RED = 0, BLACK = 1
 };
 using Color::RED;
 using Color::BLACK;
 inline Color operator!(Color color) { return color == RED ? BLACK : RED; }
 
-template<typename T>
+// Nodes link to each other by pointer.
+struct pointer_layout {};
+
+// Nodes link to each other by 32-bit index into the node pool, and pack the color into the size field.
+// Much smaller nodes for small keys, at the cost of resolving indices and a limit of 2^31 - 1 elements (2^32 - 1 with 64-bit sizes).
+struct compact_layout {};
+
+// insert(key) and erase(key) look the key up first, then link the node in or cut it out and walk back up from it, counting sizes and fixing the red-black rules.
+struct bottom_up_rebalancing {};
+
+// insert(key) and erase(key) walk down once, comparing once per level and counting sizes on the way.
+// insert fixes the red-black rules on the way down as well. erase cuts out the element's predecessor at the bottom of the same descent and fixes bottom-up from there,
+// which takes amortized O(1) steps, while a top-down erase rotates at many levels of the path.
+// The invariants are the same, so every other operation works as it does bottom-up. Inserting at a hint and erasing through an iterator don't descend, so they stay bottom-up.
+struct single_pass_rebalancing {};
+
+// Keeps no aggregate besides the subtree sizes.
+// An augmentation is a monoid over the elements: value_type, identity(), lift(element) and an associative combine(a, b), applied in key order.
+struct no_augmentation {
+    struct value_type {};
+    
+    static value_type identity() { return {}; }
+    
+    template<typename T>
+    static value_type lift(const T &) { return {}; }
+    
+    static value_type combine(value_type, value_type) { return {}; }
+};
+
+// Whether Compare declares is_transparent, letting lookups take any type it can compare with the elements.
+template<typename Compare, typename = void>
+inline constexpr bool is_transparent_v = false;
+
+template<typename Compare>
+inline constexpr bool is_transparent_v<Compare, void_t<typename Compare::is_transparent>> = true;
+
+// FNV-1a over 64-bit words, checksumming saved sets. The tail of each update is zero-padded, so chunks whose sizes are multiples of 8 hash like their concatenation.
+class checksum64 {
+public:
+    void update(const void *data, size_t bytes) {
+        auto p = static_cast<const unsigned char *>(data);
+        for (; bytes >= 8; p += 8, bytes -= 8) mix(p, 8);
+        if (bytes) mix(p, bytes);
+    }
+    
+    [[nodiscard]] uint64_t value() const { return hash_; }
+
+private:
+    uint64_t hash_ = 0xcbf29ce484222325;
+    
+    void mix(const unsigned char *p, size_t bytes) {
+        uint64_t word = 0;
+        memcpy(&word, p, bytes);
+        hash_ = (hash_ ^ word) * 0x100000001b3;
+    }
+};
+
+// Header of the files ordered_set::save writes, followed by the elements in order as raw bytes (in the machine's byte order).
+// The tree's shape and colors aren't stored, they only depend on the size: load rebuilds them, and mapped_ordered_set searches the sorted elements as they are.
+struct ordered_set_file_header {
+    static constexpr char MAGIC[8] = {'O', 'R', 'D', 'S', 'E', 'T', '\0', '\0'};
+    static constexpr uint32_t VERSION = 1;
+    
+    char magic[8];
+    uint32_t version;
+    uint32_t element_size;
+    uint64_t size;
+    uint64_t checksum; // checksum64 of the elements.
+    
+    // Throws runtime_error unless this is a header of the current version for elements of element_size bytes.
+    void check(size_t element_size) const {
+        if (memcmp(magic, MAGIC, sizeof magic) != 0) throw runtime_error("Not an ordered_set file.");
+        if (version != VERSION) throw runtime_error("Unsupported ordered_set file version.");
+        if (this->element_size != element_size) throw runtime_error("The file holds elements of a different size.");
+    }
+};
+
+// What an ordered_set whose policy has stats = true has counted since it was constructed or its stats were reset, see ordered_set::stats().
+// A descent is a walk down from the root to find a key, an order or the place of a new node, and its depth is the number of nodes it visits.
+struct ordered_set_stats {
+    uint64_t lookups = 0; // find, lower_bound, upper_bound
+    uint64_t rank_queries = 0; // order_of_key, count
+    uint64_t select_queries = 0; // find_by_order, begin, operator[]
+    uint64_t inserts = 0; // insert and emplace of one element, whether or not it was there already
+    uint64_t erases = 0; // erase of one element, whether or not it was there
+    uint64_t bulk_operations = 0; // range insert and erase, split, join, the set operations, load and the parallel operations
+    uint64_t comparisons = 0;
+    uint64_t rotations = 0;
+    uint64_t recolors = 0; // Recoloring steps of insert_fix and erase_fix.
+    uint64_t descents = 0;
+    uint64_t descent_depth = 0; // Summed over all descents, divide by descents for the average.
+    uint64_t max_descent_depth = 0;
+    
+    // Every counter with its name, for exporting them.
+    static constexpr array<pair<const char *, uint64_t ordered_set_stats::*>, 12> counters() {
+        return {{
+            {"lookups", &ordered_set_stats::lookups}, {"rank_queries", &ordered_set_stats::rank_queries},
+            {"select_queries", &ordered_set_stats::select_queries}, {"inserts", &ordered_set_stats::inserts},
+            {"erases", &ordered_set_stats::erases}, {"bulk_operations", &ordered_set_stats::bulk_operations},
+            {"comparisons", &ordered_set_stats::comparisons}, {"rotations", &ordered_set_stats::rotations},
+            {"recolors", &ordered_set_stats::recolors}, {"descents", &ordered_set_stats::descents},
+            {"descent_depth", &ordered_set_stats::descent_depth}, {"max_descent_depth", &ordered_set_stats::max_descent_depth},
+        }};
+    }
+};
+
+// The shape of a tree that passed ordered_set::validate.
+struct ordered_set_shape {
+    int black_height = 0; // Black nodes on every path down from the root.
+    vector<int> depth_histogram; // depth_histogram[d] nodes at depth d, the root being at depth 0.
+    
+    [[nodiscard]] int height() const { return int(depth_histogram.size()); }
+};
+
+// Default tree configuration, derive from it and override members to change them.
+struct tree_policy {
+    using layout = pointer_layout;
+    using augmentation = no_augmentation;
+    // Whether equal elements may repeat, see ordered_multiset.
+    static constexpr bool multi = false;
+    // Whether to count operations, see stats_policy.
+    static constexpr bool stats = false;
+    // How insert(key) and erase(key) rebalance, see single_pass_rebalancing.
+    using rebalancing = bottom_up_rebalancing;
+    // Unsigned type of sizes and orders, and of the size field in every node. void picks the layout's:
+    // size_t for pointer_layout, whose nodes have room for it, and uint32_t for compact_layout, whose indices can't go much further.
+    // uint32_t shrinks pointer_layout nodes by 8 bytes when the key leaves 4 spare, at a limit of 2^31 - 1 elements.
+    using size_type = void;
+};
+
+// Hands out tree nodes from geometrically growing slabs, recycling erased nodes through a freelist.
+// Nodes never move, and memory is only returned to Allocator on release(), which drops whole slabs.
+// Link is either Node * or an unsigned index, 1-based so that 0 can be the null link.
+template<typename Node, typename Link, typename Allocator>
+class node_pool {
+public:
+    node_pool() = default;
+    
+    explicit node_pool(const Allocator &alloc);
+    
+    node_pool(node_pool &&other) noexcept;
+    
+    node_pool &operator=(node_pool &&other) noexcept;
+    
+    ~node_pool();
+    
+    template<typename... Args>
+    Link allocate(Args &&... args);
+    
+    void deallocate(Link u);
+    
+    Node &at(Link u) const;
+    
+    // Frees every slab without destroying the nodes in it.
+    void release();
+    
+    // Slabs take indices up to twice their capacity less FIRST_SLAB, the ones before them holding capacity - FIRST_SLAB nodes.
+    static constexpr size_t max_nodes() {
+        if constexpr (INDEXED) {
+            size_t capacity = FIRST_SLAB;
+            while (4 * capacity - FIRST_SLAB <= numeric_limits<Link>::max()) capacity *= 2;
+            return 2 * capacity - FIRST_SLAB;
+        }
+        return numeric_limits<size_t>::max();
+    }
+    
+    [[nodiscard]] size_t memory_usage() const;
+
+private:
+    union Slot {
+        Link next;
+        Node node;
+        
+        Slot() {}
+        
+        ~Slot() {}
+    };
+    
+    using slot_allocator = typename allocator_traits<Allocator>::template rebind_alloc<Slot>;
+    using traits = allocator_traits<slot_allocator>;
+    
+    static constexpr size_t FIRST_SLAB = 32;
+    static constexpr bool INDEXED = !is_pointer_v<Link>;
+    
+    slot_allocator alloc_;
+    vector<pair<Slot *, size_t>> slabs_;
+    size_t used_ = 0; // Slots handed out from the last slab.
+    Link free_{};
+    
+    Slot &slot(Link u) const;
+};
+
+template<typename T, typename Compare = less<T>, typename Allocator = allocator<T>, typename Policy = tree_policy>
 class ordered_set {
 private:
     class Node;
+    
+    static constexpr bool COMPACT = is_same_v<typename Policy::layout, compact_layout>;
+    
+    using link = conditional_t<COMPACT, uint32_t, Node *>;
+    using augmentation = typename Policy::augmentation;
+    
+    static constexpr bool AUGMENTED = !is_same_v<augmentation, no_augmentation>;
+    static constexpr bool TRANSPARENT = is_transparent_v<Compare>;
+    static constexpr bool MULTI = Policy::multi;
+    static constexpr bool STATS = Policy::stats;
+    static constexpr bool SINGLE_PASS = is_same_v<typename Policy::rebalancing, single_pass_rebalancing>;
 
 public:
     class Iterator;
     
+    using aggregate_type = typename augmentation::value_type;
+    using size_type = conditional_t<is_void_v<typename Policy::size_type>, conditional_t<COMPACT, uint32_t, size_t>, typename Policy::size_type>;
+    using difference_type = make_signed_t<size_type>;
+    
+    static_assert(is_unsigned_v<size_type>, "size_type must be unsigned.");
+    
     ordered_set() = default;
     
+    explicit ordered_set(const Allocator &alloc);
+    
+    explicit ordered_set(const Compare &comp, const Allocator &alloc = Allocator());
+    
     ordered_set(initializer_list<T> values);
     
-    [[nodiscard]] int size() const;
+    template<typename InputIt>
+    ordered_set(InputIt first, InputIt last);
+    
+    ordered_set(ordered_set &&other) noexcept;
+    
+    ordered_set &operator=(ordered_set &&other) noexcept;
+    
+    ~ordered_set();
+    
+    [[nodiscard]] size_type size() const;
+    
+    [[nodiscard]] size_type max_size() const;
     
     [[nodiscard]] bool empty() const;
     
+    [[nodiscard]] size_t memory_usage() const;
+    
+    ordered_set_stats stats() const requires STATS;
+    
+    void reset_stats() requires STATS;
+    
+    ordered_set_shape validate() const;
+    
     void clear();
     
-    const T &operator[](int index);
+    template<typename InputIt>
+    void assign(InputIt first, InputIt last);
+    
+    const T &operator[](size_type index);
     
     Iterator begin() const;
     
     Iterator end() const;
     
-    Iterator find(T key) const;
+    Iterator find(const T &key) const;
+    
+    template<typename K>
+    Iterator find(const K &key) const requires TRANSPARENT;
+    
+    Iterator lower_bound(const T &key) const;
+    
+    template<typename K>
+    Iterator lower_bound(const K &key) const requires TRANSPARENT;
+    
+    Iterator upper_bound(const T &key) const;
+    
+    template<typename K>
+    Iterator upper_bound(const K &key) const requires TRANSPARENT;
+    
+    Iterator find_by_order(size_type k) const;
+    
+    size_type order_of_key(const T &key) const;
+    
+    template<typename K>
+    size_type order_of_key(const K &key) const requires TRANSPARENT;
+    
+    size_type count(const T &key) const;
+    
+    template<typename K>
+    size_type count(const K &key) const requires TRANSPARENT;
+    
+    void order_of_keys(span<const T> keys, span<size_type> out) const;
+    
+    void order_of_keys(span<const T> keys, span<size_type> out, span<bool> found) const;
+    
+    void find_by_orders(span<const size_type> orders, span<Iterator> out) const;
+    
+    size_type count_in_range(const T &lo, const T &hi) const;
+    
+    Iterator kth_at_or_after(const T &key, size_type k) const;
+    
+    Iterator quantile_in_range(const T &lo, const T &hi, double q) const;
+    
+    aggregate_type fold(const T &lo, const T &hi) const;
+    
+    template<typename F>
+    void for_each(F f) const;
+    
+    template<typename F>
+    void for_each_in_range(const T &lo, const T &hi, F f) const;
+    
+    pair<Iterator, bool> insert(const T &key);
+    
+    pair<Iterator, bool> insert(T &&key);
+    
+    Iterator insert(Iterator hint, const T &key);
+    
+    Iterator insert(Iterator hint, T &&key);
+    
+    template<typename InputIt>
+    void insert(InputIt first, InputIt last);
     
-    Iterator lower_bound(T key) const;
+    template<typename InputIt>
+    void parallel_insert(InputIt first, InputIt last, int threads = 0);
     
-    Iterator upper_bound(T key) const;
+    template<typename... Args>
+    pair<Iterator, bool> emplace(Args &&... args);
     
-    Iterator find_by_order(int k) const;
+    bool erase(const T &key);
     
-    int order_of_key(T key) const;
+    template<typename K>
+    bool erase(const K &key) requires TRANSPARENT;
     
-    pair<Iterator, bool> insert(T key);
+    Iterator erase(Iterator pos);
     
-    bool erase(T key);
+    Iterator erase(Iterator first, Iterator last);
+    
+    void save(const string &path) const requires is_trivially_copyable_v<T>;
+    
+    void load(const string &path) requires is_trivially_copyable_v<T>;
+    
+    // split and split_by_order leave both sets on one node pool, which isn't thread-safe: they can't be written from different threads, even though they look independent.
+    // join and the set operations move other's elements into this set's pool when the pools differ, in O(size of other), and never move this set's nodes.
+    ordered_set split(const T &key);
+    
+    ordered_set split_by_order(size_type k);
+    
+    void join(ordered_set &&other);
+    
+    void unite(ordered_set &&other);
+    
+    void intersect(ordered_set &&other);
+    
+    void subtract(ordered_set &&other);
+    
+    void parallel_unite(ordered_set &&other, int threads = 0);
+    
+    void parallel_intersect(ordered_set &&other, int threads = 0);
+    
+    template<typename F>
+    void parallel_for_each(Iterator first, Iterator last, F f, int threads = 0) const;
     
     class Iterator {
+        friend class ordered_set;
+    
     public:
-        explicit Iterator(const ordered_set *tree, Node *ptr = nullptr);
+        using iterator_category = bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = ordered_set::difference_type;
+        using pointer = const T *;
+        using reference = const T &;
+        
+        explicit Iterator(const ordered_set *tree, link ptr = {});
         
         const T &operator*();
         
@@ -76,11 +403,11 @@ public:
         
         Iterator operator--(int);
         
-        Iterator operator+(int n);
+        Iterator operator+(difference_type n);
         
-        Iterator operator-(int n);
+        Iterator operator-(difference_type n);
     
-        int operator-(Iterator other);
+        difference_type operator-(Iterator other);
     
         bool operator<(Iterator other);
     
@@ -95,54 +422,246 @@ public:
         bool operator>(Iterator other);
     
     private:
-        Node *ptr_;
+        link ptr_;
         const ordered_set *tree_;
-        int order();
+        size_type order();
     };
 
+protected:
+    template<typename K, typename Make>
+    pair<Iterator, bool> insert_missing(const K &key, Make make);
+
 private:
     class Node {
         friend class ordered_set;
     
     public:
         
-        Node() = default;
-        
-        explicit Node(T value) : value_(value) {}
+        template<typename... Args>
+        explicit Node(Args &&... args) : value_(std::forward<Args>(args)...), aggregate_(augmentation::lift(value_)) {}
     
     private:
         class Array {
         public:
-            unique_ptr<Node> data[2];
-            unique_ptr<Node> &operator[](Direction direction) { return data[direction == RIGHT]; }
-            const unique_ptr<Node> &operator[](Direction direction) const { return data[direction == RIGHT]; }
+            link data[2]{};
+            link &operator[](Direction direction) { return data[direction == RIGHT]; }
+            link operator[](Direction direction) const { return data[direction == RIGHT]; }
         };
         
         T value_;
+        // Right after the value, so that 32-bit sizes fill the padding after a 4-byte key.
+        size_type size_: numeric_limits<size_type>::digits - 1 = 1;
+        Color color_: 1 = RED;
         Array child_;
-        Node *parent_ = nullptr;
-        Color color_ = RED;
-        int size_ = 1;
+        link parent_{};
+        [[no_unique_address]] aggregate_type aggregate_;
     };
     
-    unique_ptr<Node> root_;
+    // Range inserts of at least size() / BULK_RATIO elements rebuild the tree instead of inserting one by one.
+    static constexpr int BULK_RATIO = 8;
+    
+    // Range erases of at least SPLIT_ERASE_MIN elements split the range out of the tree instead of erasing one by one.
+    static constexpr int SPLIT_ERASE_MIN = 16;
+    
+    // Elements are written and read this many at a time. A multiple of 8, so that checksumming chunk by chunk matches checksumming the whole.
+    static constexpr size_t FILE_CHUNK = 4096;
+    
+    // Parallel operations give each thread at least this many elements.
+    static constexpr int PARALLEL_GRAIN = 1 << 14;
+    
+    // A red-black tree of n nodes is at most 2 log2(n + 1) levels deep, which bounds the stack of a scan.
+    static constexpr int MAX_HEIGHT = 2 * numeric_limits<size_type>::digits;
+    
+    // Unsorted batch queries run this many descents side by side, so that their cache misses overlap.
+    static constexpr int BATCH_WIDTH = 16;
+    
+    // kth_at_or_after climbs back up the path to key for k below this. A larger k is answered high up the tree, where descending again from the root is faster.
+    static constexpr size_type KTH_CLIMB_MAX = 256;
+    
+    using pool_type = node_pool<Node, link, Allocator>;
+    
+    // A detached tree with a black root, or an empty one, along with its black height (the number of black nodes on any path down from the root).
+    struct Subtree {
+        link root;
+        int height;
+    };
+    
+    struct NoStats {};
+    
+    link root_{};
+    // Sets split off each other share a pool, so that their nodes can move between them.
+    shared_ptr<pool_type> pool_;
+    [[no_unique_address]] Compare comp_;
+    // Counted from const member functions too, which may run concurrently, so every update is atomic.
+    [[no_unique_address]] mutable conditional_t<STATS, ordered_set_stats, NoStats> stats_;
+    
+    ordered_set(shared_ptr<pool_type> pool, link root, const Compare &comp);
+    
+    void tally(uint64_t ordered_set_stats::*counter, uint64_t n = 1) const;
+    
+    void tally_descent(int depth) const;
+    
+    template<typename A, typename B>
+    bool compare(const A &a, const B &b) const;
+    
+    auto comparator() const;
+    
+    template<typename A, typename B>
+    bool equivalent(const A &a, const B &b) const;
+    
+    template<typename K>
+    link locate(const K &key) const;
+    
+    template<typename K>
+    link bound(const K &key, bool strict) const;
+    
+    template<typename K>
+    size_type rank(const K &key, bool strict = false) const;
+    
+    link range_top(const T &lo, const T &hi) const;
+    
+    pair<size_type, size_type> count_sides(link u, const T &lo, const T &hi) const;
+    
+    size_type count_at_least(link u, const T &lo) const;
+    
+    size_type count_less(link u, const T &hi) const;
+    
+    link select(link u, size_type k) const;
+    
+    template<typename K>
+    pair<Iterator, bool> insert_unique(K &&key);
+    
+    template<typename K, typename Make>
+    pair<Iterator, bool> insert_node(const K &key, Make make);
+    
+    template<typename K, typename Make>
+    pair<Iterator, bool> insert_single_pass(const K &key, Make make);
+    
+    template<typename K>
+    Iterator insert_hint(link next, K &&key);
     
-    static void add_child(Node *u, Node *child, Direction direction);
+    pool_type &pool();
     
-    static void update_size(Node *u, bool recursive = true);
+    Node &node(link u) const;
     
-    static Direction get_direction(Node *u);
+    size_type subtree_size(link u) const;
     
-    void rotate(Node *u, Direction direction);
+    aggregate_type aggregate(link u) const;
     
-    pair<Iterator, bool> insert(Node *u);
+    Color color(link u) const;
     
-    void insert_fix(Node *u);
+    void swap_colors(link u, link v);
     
-    bool erase(Node *u);
+    void add_child(link u, link child, Direction direction);
     
-    void erase_fix(Node *u);
+    void update_size(link u, bool recursive = true);
+    
+    void add_size(link u, int delta);
+    
+    void add_path_size(link u, link stop, int delta);
+    
+    Direction get_direction(link u) const;
+    
+    size_type order_of(link u) const;
+    
+    link neighbor(link u, Direction direction) const;
+    
+    void order_of_keys(span<const T> keys, size_type *out, bool *found) const;
+    
+    void order_of_keys(link u, size_type before, const T *first, const T *last, size_type *out) const;
+    
+    void find_by_orders(link u, size_type before, const size_type *first, const size_type *last, Iterator *out) const;
+    
+    link advance(link u, difference_type n) const;
+    
+    template<typename F>
+    void scan(link *stack, int top, link last, F &f) const;
+    
+    void rotate(link u, Direction direction);
+    
+    bool insert_fix(link u);
+    
+    link restructure(link u);
+    
+    template<typename ForwardIt>
+    void merge_sorted(ForwardIt first, ForwardIt last);
+    
+    link build(link &head, size_type n, int depth, int red_depth);
+    
+    bool erase(link u);
+    
+    template<typename K>
+    bool erase_single_pass(const K &key);
+    
+    void swap_with_successor(link u, link v);
+    
+    void erase_fix(link u);
+    
+    void free_subtree(link u);
+    
+    int black_height(link u) const;
+    
+    int validate(link u, int depth, link &prev, ordered_set_shape &shape) const;
+    
+    Subtree detach(link u, int height);
+    
+    Subtree join(Subtree l, link k, Subtree r);
+    
+    Subtree join(Subtree l, Subtree r);
+    
+    tuple<Subtree, link, Subtree> split(Subtree t, const T &key);
+    
+    pair<Subtree, Subtree> split_by_order(Subtree t, size_type k);
+    
+    pair<Subtree, link> split_last(Subtree t);
+    
+    Subtree unite(Subtree a, Subtree b);
+    
+    Subtree intersect(Subtree a, Subtree b);
+    
+    Subtree subtract(Subtree a, Subtree b);
+    
+    void share_pool(ordered_set &other);
+    
+    static int task_count(int threads, size_t work);
+    
+    template<typename F>
+    static void fork_join(int tasks, F f);
+    
+    template<typename F>
+    void walk(size_type lo, size_type hi, int tasks, F f) const;
+    
+    vector<link> links(int tasks) const;
+    
+    void sort_links(vector<link> &nodes, int tasks) const;
+    
+    void merge_links(const link *a, size_type na, const link *b, size_type nb, link *out, int part, int parts) const;
+    
+    template<typename Keep>
+    vector<link> compact_links(const vector<link> &nodes, Keep keep, int tasks);
+    
+    link build(const link *nodes, size_type n, int depth, int red_depth, int tasks);
+    
+    void assemble(const vector<link> &nodes, int tasks);
+};
+
+// Lets a policy's tree hold equal elements.
+template<typename Policy = tree_policy>
+struct multi_policy : Policy {
+    static constexpr bool multi = true;
+};
+
+// Lets a policy's tree count its operations, comparisons, rotations and descents, see ordered_set_stats.
+// Every count is an atomic add, so it costs a little on every operation, without the policy it costs nothing.
+template<typename Policy = tree_policy>
+struct stats_policy : Policy {
+    static constexpr bool stats = true;
 };
 
+// An ordered_set that keeps equal elements, each inserted after the ones already there, so that they stay in insertion order.
+// count(key) is the difference of two ranks, and erase(key) erases a single element (the first equal one), erase(lower_bound(key), upper_bound(key)) erases them all.
+// unite, intersect and subtract are not available.
+template<typename T, typename Compare = less<T>, typename Allocator = allocator<T>, typename Policy = tree_policy>
+using ordered_multiset = ordered_set<T, Compare, Allocator, multi_policy<Policy>>;
 
 #endif //ORDERED_SET_ORDERED_SET_H
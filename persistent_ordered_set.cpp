@@ -0,0 +1,398 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#include "persistent_ordered_set.h"
+
+#define TEMPLATE template<typename T, typename Allocator>
+#define PERSISTENT_ORDERED_SET persistent_ordered_set<T, Allocator>
+#define iterator typename PERSISTENT_ORDERED_SET::Iterator
+#define node_ref typename PERSISTENT_ORDERED_SET::Ref
+
+
+TEMPLATE
+PERSISTENT_ORDERED_SET::persistent_ordered_set(initializer_list<T> values) : persistent_ordered_set(values.begin(), values.end()) {}
+
+// Builds a perfectly balanced tree in O(n) if [first, last) is sorted, O(n log(n)) otherwise.
+TEMPLATE
+template<typename InputIt>
+PERSISTENT_ORDERED_SET::persistent_ordered_set(InputIt first, InputIt last) {
+    vector<T> values(first, last);
+    if (!is_sorted(values.begin(), values.end())) sort(values.begin(), values.end());
+    values.erase(unique(values.begin(), values.end()), values.end());
+    root_ = build(values.data(), values.size());
+}
+
+
+// Tree Properties
+
+TEMPLATE
+typename PERSISTENT_ORDERED_SET::size_type PERSISTENT_ORDERED_SET::size() const { return subtree_size(root_.get()); }
+
+TEMPLATE
+bool PERSISTENT_ORDERED_SET::empty() const { return !root_; }
+
+// Drops this version, its nodes are freed unless another version shares them.
+TEMPLATE
+void PERSISTENT_ORDERED_SET::clear() { root_ = Ref(); }
+
+
+// Getting
+
+TEMPLATE
+const T &PERSISTENT_ORDERED_SET::operator[](size_type index) const { return *find_by_order(index); }
+
+// Returns an iterator to the smallest element.
+TEMPLATE
+iterator PERSISTENT_ORDERED_SET::begin() const { return find_by_order(0); }
+
+// Returns past-the-end (end()) iterator.
+TEMPLATE
+iterator PERSISTENT_ORDERED_SET::end() const { return Iterator(root_.get(), size(), nullptr); }
+
+// Returns an iterator to the element equal to key, or end() if there is none.
+TEMPLATE
+iterator PERSISTENT_ORDERED_SET::find(T key) const {
+    Iterator it = lower_bound(key);
+    return it.ptr_ && key == it.ptr_->value_ ? it : end();
+}
+
+// Returns an iterator to the smallest element not less than key.
+TEMPLATE
+iterator PERSISTENT_ORDERED_SET::lower_bound(T key) const {
+    const Node *ret = nullptr;
+    size_type order = 0;
+    for (const Node *u = root_.get(); u;) {
+        if (key <= u->value_) {
+            ret = u;
+            u = u->left_.get();
+        } else {
+            order += subtree_size(u->left_.get()) + 1;
+            u = u->right_.get();
+        }
+    }
+    return Iterator(root_.get(), order, ret);
+}
+
+// Returns an iterator to the smallest element greater than key.
+TEMPLATE
+iterator PERSISTENT_ORDERED_SET::upper_bound(T key) const {
+    const Node *ret = nullptr;
+    size_type order = 0;
+    for (const Node *u = root_.get(); u;) {
+        if (key < u->value_) {
+            ret = u;
+            u = u->left_.get();
+        } else {
+            order += subtree_size(u->left_.get()) + 1;
+            u = u->right_.get();
+        }
+    }
+    return Iterator(root_.get(), order, ret);
+}
+
+// Returns an iterator to the k-th smallest element (0-indexed), or end() if k == size().
+// A negative order converted to size_type lands far above size() and throws like any other.
+TEMPLATE
+iterator PERSISTENT_ORDERED_SET::find_by_order(size_type k) const {
+    if (k > size()) throw out_of_range("Order out of range.");
+    return Iterator(root_.get(), k, at(root_.get(), k));
+}
+
+// Returns the number of elements less than key.
+TEMPLATE
+typename PERSISTENT_ORDERED_SET::size_type PERSISTENT_ORDERED_SET::order_of_key(T key) const {
+    size_type order = 0;
+    for (const Node *u = root_.get(); u;) {
+        if (key <= u->value_) {
+            u = u->left_.get();
+        } else {
+            order += subtree_size(u->left_.get()) + 1;
+            u = u->right_.get();
+        }
+    }
+    return order;
+}
+
+
+// Updating
+
+// Inserts key, copying the path down to it. Other versions are unaffected.
+// Returns whether key was inserted.
+TEMPLATE
+bool PERSISTENT_ORDERED_SET::insert(T key) {
+    bool inserted = false;
+    root_ = insert(root_, key, inserted);
+    return inserted;
+}
+
+// Erases key, copying the path down to it. Other versions are unaffected.
+// Returns whether key was erased.
+TEMPLATE
+bool PERSISTENT_ORDERED_SET::erase(T key) {
+    bool erased = false;
+    root_ = erase(root_, key, erased);
+    return erased;
+}
+
+
+// Node Functions
+
+TEMPLATE
+typename PERSISTENT_ORDERED_SET::size_type PERSISTENT_ORDERED_SET::subtree_size(const Node *u) { return u ? u->size_ : 0; }
+
+TEMPLATE
+node_ref PERSISTENT_ORDERED_SET::make(Ref left, const T &value, Ref right) {
+    node_allocator alloc;
+    Node *u = traits::allocate(alloc, 1);
+    traits::construct(alloc, u, std::move(left), value, std::move(right));
+    return Ref(u);
+}
+
+// Joins left, value and right, whose weights were balanced until one of them changed by a single element.
+// Restores balance with a single or double rotation, building only new nodes.
+TEMPLATE
+node_ref PERSISTENT_ORDERED_SET::balance(Ref left, const T &value, Ref right) {
+    size_type l_size = subtree_size(left.get()), r_size = subtree_size(right.get());
+    if (l_size + r_size <= 1) return make(std::move(left), value, std::move(right));
+    if (r_size > DELTA * l_size) {
+        const Node *r = right.get();
+        const Node *rl = r->left_.get();
+        if (subtree_size(rl) < RATIO * subtree_size(r->right_.get()))
+            return make(make(std::move(left), value, r->left_), r->value_, r->right_);
+        return make(make(std::move(left), value, rl->left_), rl->value_, make(rl->right_, r->value_, r->right_));
+    }
+    if (l_size > DELTA * r_size) {
+        const Node *l = left.get();
+        const Node *lr = l->right_.get();
+        if (subtree_size(lr) < RATIO * subtree_size(l->left_.get()))
+            return make(l->left_, l->value_, make(l->right_, value, std::move(right)));
+        return make(make(l->left_, l->value_, lr->left_), lr->value_, make(lr->right_, value, std::move(right)));
+    }
+    return make(std::move(left), value, std::move(right));
+}
+
+// Returns u's subtree with key inserted, u itself if key is already there.
+TEMPLATE
+node_ref PERSISTENT_ORDERED_SET::insert(const Ref &u, const T &key, bool &inserted) {
+    if (!u) {
+        inserted = true;
+        return make(Ref(), key, Ref());
+    }
+    if (key == u->value_) return u;
+    if (key < u->value_) {
+        Ref left = insert(u->left_, key, inserted);
+        return inserted ? balance(std::move(left), u->value_, u->right_) : u;
+    }
+    Ref right = insert(u->right_, key, inserted);
+    return inserted ? balance(u->left_, u->value_, std::move(right)) : u;
+}
+
+// Returns u's subtree with key erased, u itself if key is not there.
+TEMPLATE
+node_ref PERSISTENT_ORDERED_SET::erase(const Ref &u, const T &key, bool &erased) {
+    if (!u) return u;
+    if (key < u->value_) {
+        Ref left = erase(u->left_, key, erased);
+        return erased ? balance(std::move(left), u->value_, u->right_) : u;
+    }
+    if (u->value_ < key) {
+        Ref right = erase(u->right_, key, erased);
+        return erased ? balance(u->left_, u->value_, std::move(right)) : u;
+    }
+    erased = true;
+    if (!u->left_) return u->right_;
+    if (!u->right_) return u->left_;
+    const Node *successor;
+    Ref right = erase_min(u->right_, successor);
+    return balance(u->left_, successor->value_, std::move(right));
+}
+
+// Returns u's subtree without its smallest node, which is written to min and stays alive as long as u.
+TEMPLATE
+node_ref PERSISTENT_ORDERED_SET::erase_min(const Ref &u, const Node *&min) {
+    if (!u->left_) {
+        min = u.get();
+        return u->right_;
+    }
+    Ref left = erase_min(u->left_, min);
+    return balance(std::move(left), u->value_, u->right_);
+}
+
+// Builds a perfectly balanced tree from n sorted distinct values.
+TEMPLATE
+node_ref PERSISTENT_ORDERED_SET::build(const T *first, size_type n) {
+    if (n == 0) return Ref();
+    size_type mid = n / 2;
+    return make(build(first, mid), first[mid], build(first + mid + 1, n - mid - 1));
+}
+
+// Returns the k-th smallest node of u's subtree, or nullptr if there is none.
+TEMPLATE
+const typename PERSISTENT_ORDERED_SET::Node *PERSISTENT_ORDERED_SET::at(const Node *u, size_type k) {
+    while (u) {
+        size_type l_size = subtree_size(u->left_.get());
+        if (l_size == k) return u;
+        if (l_size > k) {
+            u = u->left_.get();
+        } else {
+            k -= l_size + 1;
+            u = u->right_.get();
+        }
+    }
+    return nullptr;
+}
+
+TEMPLATE
+void PERSISTENT_ORDERED_SET::destroy(Node *u) {
+    node_allocator alloc;
+    traits::destroy(alloc, u);
+    traits::deallocate(alloc, u, 1);
+}
+
+TEMPLATE
+PERSISTENT_ORDERED_SET::Node::Node(Ref left, T value, Ref right)
+        : value_(std::move(value)), size_(subtree_size(left.get()) + subtree_size(right.get()) + 1),
+          left_(std::move(left)), right_(std::move(right)) {}
+
+
+// Ref
+
+TEMPLATE
+PERSISTENT_ORDERED_SET::Ref::Ref(Node *node) : node_(node) { if (node_) node_->refs_.fetch_add(1, memory_order_relaxed); }
+
+TEMPLATE
+PERSISTENT_ORDERED_SET::Ref::Ref(const Ref &other) : Ref(other.node_) {}
+
+TEMPLATE
+PERSISTENT_ORDERED_SET::Ref::Ref(Ref &&other) noexcept : node_(exchange(other.node_, nullptr)) {}
+
+TEMPLATE
+node_ref &PERSISTENT_ORDERED_SET::Ref::operator=(Ref other) noexcept {
+    swap(node_, other.node_);
+    return *this;
+}
+
+// Frees the node when this was the last reference, which releases its children in turn.
+TEMPLATE
+PERSISTENT_ORDERED_SET::Ref::~Ref() {
+    if (node_ && node_->refs_.fetch_sub(1, memory_order_acq_rel) == 1) destroy(node_);
+}
+
+
+// Iterator Functions
+
+TEMPLATE
+PERSISTENT_ORDERED_SET::Iterator::Iterator(const Node *root, size_type order, const Node *ptr) : root_(root), order_(order), ptr_(ptr) {}
+
+TEMPLATE
+const T &PERSISTENT_ORDERED_SET::Iterator::operator*() const {
+    if (!ptr_) throw out_of_range("Dereferencing end iterator.");
+    return ptr_->value_;
+}
+
+TEMPLATE
+const T *PERSISTENT_ORDERED_SET::Iterator::operator->() const {
+    if (!ptr_) throw out_of_range("Dereferencing end iterator.");
+    return &ptr_->value_;
+}
+
+// Goes down the right child's left spine if there is a right child, and otherwise up past every ancestor it's the right subtree of, in amortized O(1).
+TEMPLATE
+iterator &PERSISTENT_ORDERED_SET::Iterator::operator++() {
+    if (!ptr_) throw out_of_range("Iterator out of range.");
+    if (path_.empty()) seek(order_);
+    const Node *u = path_.back();
+    if (u->right_) {
+        for (u = u->right_.get(); u; u = u->left_.get()) path_.push_back(u);
+    } else {
+        path_.pop_back();
+        while (!path_.empty() && path_.back()->right_.get() == u) u = path_.back(), path_.pop_back();
+    }
+    order_++;
+    ptr_ = path_.empty() ? nullptr : path_.back();
+    return *this;
+}
+
+TEMPLATE
+iterator PERSISTENT_ORDERED_SET::Iterator::operator++(int) {
+    Iterator temp = *this;
+    ++*this;
+    return temp;
+}
+
+// The mirror image of ++, except that -- on end() descends to the last element.
+TEMPLATE
+iterator &PERSISTENT_ORDERED_SET::Iterator::operator--() {
+    if (order_ == 0) throw out_of_range("Iterator out of range.");
+    if (!ptr_) {
+        seek(order_ - 1);
+        return *this;
+    }
+    if (path_.empty()) seek(order_);
+    const Node *u = path_.back();
+    if (u->left_) {
+        for (u = u->left_.get(); u; u = u->right_.get()) path_.push_back(u);
+    } else {
+        path_.pop_back();
+        while (path_.back()->left_.get() == u) u = path_.back(), path_.pop_back();
+    }
+    order_--;
+    ptr_ = path_.back();
+    return *this;
+}
+
+TEMPLATE
+iterator PERSISTENT_ORDERED_SET::Iterator::operator--(int) {
+    Iterator temp = *this;
+    --*this;
+    return temp;
+}
+
+// Moving before the first element wraps order_ + n around to far above the size, so one check covers both ends.
+TEMPLATE
+iterator PERSISTENT_ORDERED_SET::Iterator::operator+(difference_type n) const {
+    size_type order = order_ + n;
+    if (order > subtree_size(root_)) throw out_of_range("Iterator out of range.");
+    return Iterator(root_, order, at(root_, order));
+}
+
+TEMPLATE
+iterator PERSISTENT_ORDERED_SET::Iterator::operator-(difference_type n) const { return *this + -n; }
+
+TEMPLATE
+typename PERSISTENT_ORDERED_SET::difference_type PERSISTENT_ORDERED_SET::Iterator::operator-(const Iterator &other) const { return difference_type(order_ - other.order_); }
+
+TEMPLATE
+bool PERSISTENT_ORDERED_SET::Iterator::operator==(const Iterator &other) const { return root_ == other.root_ && order_ == other.order_; }
+
+TEMPLATE
+bool PERSISTENT_ORDERED_SET::Iterator::operator!=(const Iterator &other) const { return !(*this == other); }
+
+TEMPLATE
+bool PERSISTENT_ORDERED_SET::Iterator::operator<(const Iterator &other) const { return order_ < other.order_; }
+
+// Points the iterator at the element of the given order, which must exist, recording the path down to it.
+TEMPLATE
+void PERSISTENT_ORDERED_SET::Iterator::seek(size_type order) {
+    path_.clear();
+    order_ = order;
+    const Node *u = root_;
+    while (true) {
+        path_.push_back(u);
+        size_type l_size = subtree_size(u->left_.get());
+        if (order == l_size) break;
+        if (order < l_size) {
+            u = u->left_.get();
+        } else {
+            order -= l_size + 1;
+            u = u->right_.get();
+        }
+    }
+    ptr_ = u;
+}
+
+#undef node_ref
+#undef iterator
+#undef PERSISTENT_ORDERED_SET
+#undef TEMPLATE
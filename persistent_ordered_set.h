@@ -0,0 +1,177 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#ifndef ORDERED_SET_PERSISTENT_ORDERED_SET_H
+#define ORDERED_SET_PERSISTENT_ORDERED_SET_H
+
+#include "ordered_set.h"
+
+// An ordered set whose versions share structure: copying it takes a snapshot in O(1),
+// and insert / erase copy only the O(log(n)) nodes on the path they change, leaving every other version intact.
+// Nodes are immutable and reference counted, a node is freed with the last version that reaches it.
+// Balanced by subtree weight (the sizes are needed for order statistics anyway), so rebalancing only looks at sizes.
+// Allocator must be stateless, as nodes are freed by whichever version lets go of them last.
+template<typename T, typename Allocator = allocator<T>>
+class persistent_ordered_set {
+private:
+    class Node;
+    
+    class Ref;
+
+public:
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    
+    class Iterator;
+    
+    persistent_ordered_set() = default;
+    
+    persistent_ordered_set(initializer_list<T> values);
+    
+    template<typename InputIt>
+    persistent_ordered_set(InputIt first, InputIt last);
+    
+    [[nodiscard]] size_type size() const;
+    
+    [[nodiscard]] bool empty() const;
+    
+    void clear();
+    
+    const T &operator[](size_type index) const;
+    
+    Iterator begin() const;
+    
+    Iterator end() const;
+    
+    Iterator find(T key) const;
+    
+    Iterator lower_bound(T key) const;
+    
+    Iterator upper_bound(T key) const;
+    
+    Iterator find_by_order(size_type k) const;
+    
+    size_type order_of_key(T key) const;
+    
+    bool insert(T key);
+    
+    bool erase(T key);
+    
+    class Iterator {
+        friend class persistent_ordered_set;
+
+    public:
+        using iterator_category = bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = persistent_ordered_set::difference_type;
+        using pointer = const T *;
+        using reference = const T &;
+        
+        const T &operator*() const;
+        
+        const T *operator->() const;
+        
+        Iterator &operator++();
+        
+        Iterator operator++(int);
+        
+        Iterator &operator--();
+        
+        Iterator operator--(int);
+        
+        Iterator operator+(difference_type n) const;
+        
+        Iterator operator-(difference_type n) const;
+        
+        difference_type operator-(const Iterator &other) const;
+        
+        bool operator==(const Iterator &other) const;
+        
+        bool operator!=(const Iterator &other) const;
+        
+        bool operator<(const Iterator &other) const;
+
+    private:
+        // Iterators point into one version by order. Nodes have no parent links, so the path from the root to ptr_ is kept for stepping,
+        // built by the first ++ or -- and updated by the next ones, which makes a full scan O(n). Jumping by + or - re-descends from the root.
+        const Node *root_;
+        size_type order_;
+        const Node *ptr_;
+        vector<const Node *> path_;
+        
+        Iterator(const Node *root, size_type order, const Node *ptr);
+        
+        void seek(size_type order);
+    };
+
+private:
+    // Owning pointer to a shared node.
+    class Ref {
+    public:
+        Ref() = default;
+        
+        explicit Ref(Node *node);
+        
+        Ref(const Ref &other);
+        
+        Ref(Ref &&other) noexcept;
+        
+        Ref &operator=(Ref other) noexcept;
+        
+        ~Ref();
+        
+        Node *operator->() const { return node_; }
+        
+        [[nodiscard]] Node *get() const { return node_; }
+        
+        explicit operator bool() const { return node_; }
+
+    private:
+        Node *node_ = nullptr;
+    };
+    
+    class Node {
+        friend class persistent_ordered_set;
+
+    public:
+        Node(Ref left, T value, Ref right);
+
+    private:
+        T value_;
+        size_type size_;
+        atomic<int> refs_{0};
+        Ref left_, right_;
+    };
+    
+    using node_allocator = typename allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using traits = allocator_traits<node_allocator>;
+    
+    // A subtree may outweigh its sibling DELTA times before a rotation, which is double if the inner grandchild holds RATIO times the outer.
+    static constexpr int DELTA = 3;
+    static constexpr int RATIO = 2;
+    
+    Ref root_;
+    
+    // Node Functions
+    
+    static size_type subtree_size(const Node *u);
+    
+    static Ref make(Ref left, const T &value, Ref right);
+    
+    static Ref balance(Ref left, const T &value, Ref right);
+    
+    static Ref insert(const Ref &u, const T &key, bool &inserted);
+    
+    static Ref erase(const Ref &u, const T &key, bool &erased);
+    
+    static Ref erase_min(const Ref &u, const Node *&min);
+    
+    static Ref build(const T *first, size_type n);
+    
+    static const Node *at(const Node *u, size_type k);
+    
+    static void destroy(Node *u);
+};
+
+#endif //ORDERED_SET_PERSISTENT_ORDERED_SET_H
@@ -0,0 +1,152 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#include "sliding_window.h"
+#include "ordered_set.cpp"
+
+#define TEMPLATE template<typename T, typename Compare, typename Allocator, typename Policy>
+#define SLIDING_WINDOW sliding_window<T, Compare, Allocator, Policy>
+#define iterator typename SLIDING_WINDOW::Iterator
+
+TEMPLATE
+SLIDING_WINDOW::sliding_window(size_type capacity, const Compare &comp, const Allocator &alloc) : set_(comp, alloc) {
+    if (!capacity) throw invalid_argument("A window must hold at least one key.");
+    ring_.assign(capacity, set_.end());
+}
+
+
+// Getting
+
+TEMPLATE
+typename SLIDING_WINDOW::size_type SLIDING_WINDOW::size() const { return set_.size(); }
+
+TEMPLATE
+typename SLIDING_WINDOW::size_type SLIDING_WINDOW::capacity() const { return size_type(ring_.size()); }
+
+TEMPLATE
+bool SLIDING_WINDOW::empty() const { return set_.empty(); }
+
+// The keys in the window in order, for any query the window doesn't forward.
+TEMPLATE
+const typename SLIDING_WINDOW::set_type &SLIDING_WINDOW::keys() const { return set_; }
+
+// Returns the key that arrived first among the ones in the window, the next to expire.
+TEMPLATE
+const T &SLIDING_WINDOW::oldest() const {
+    if (empty()) throw out_of_range("The window is empty.");
+    Iterator it = ring_[head_];
+    return *it;
+}
+
+TEMPLATE
+const T &SLIDING_WINDOW::newest() const {
+    if (empty()) throw out_of_range("The window is empty.");
+    Iterator it = ring_[(head_ + size() - 1) % capacity()];
+    return *it;
+}
+
+// Returns the number of keys in the window less than key.
+TEMPLATE
+typename SLIDING_WINDOW::size_type SLIDING_WINDOW::order_of_key(const T &key) const { return set_.order_of_key(key); }
+
+// Returns an iterator to the (k+1)-th least key in the window, valid until the next push or advance.
+TEMPLATE
+iterator SLIDING_WINDOW::find_by_order(size_type k) const { return set_.find_by_order(k); }
+
+// Returns the q-quantile of the keys in the window by the nearest-rank method: the least key with at least q * size() keys not greater than it, the least for q = 0.
+// Throws invalid_argument unless q is in [0, 1], and out_of_range on an empty window.
+TEMPLATE
+const T &SLIDING_WINDOW::quantile(double q) const {
+    if (!(q >= 0 && q <= 1)) throw invalid_argument("Quantiles lie in [0, 1].");
+    if (empty()) throw out_of_range("The window is empty.");
+    auto rank = size_type(ceil(q * double(size())));
+    Iterator it = set_.find_by_order(rank ? min(rank, size()) - 1 : 0);
+    return *it;
+}
+
+// The lower median for an even number of keys.
+TEMPLATE
+const T &SLIDING_WINDOW::median() const { return quantile(0.5); }
+
+
+// Updating
+
+// Adds key to the window, expiring the oldest key if the window is full. Iterators to the other keys stay valid.
+TEMPLATE
+void SLIDING_WINDOW::push(const T &key) { push_key(key); }
+
+TEMPLATE
+void SLIDING_WINDOW::push(T &&key) { push_key(std::move(key)); }
+
+// Inserts before expiring, so that the window is left as it was if inserting throws.
+TEMPLATE
+template<typename K>
+void SLIDING_WINDOW::push_key(K &&key) {
+    Iterator it = set_.insert(std::forward<K>(key)).first;
+    if (size() <= capacity()) {
+        slot(size() - 1) = it;
+        return;
+    }
+    set_.erase(ring_[head_]);
+    ring_[head_] = it;
+    head_ = (head_ + 1) % capacity();
+}
+
+// Expires the k oldest keys (every key if there are at most k).
+// Each one's node is erased through its iterator, which takes amortized O(1) rebalancing and updating the sizes up the path.
+// When more keys expire than stay, the set is rebuilt over the ones that stay instead, in O(1) per key, which invalidates iterators to them.
+TEMPLATE
+void SLIDING_WINDOW::advance(size_type k) {
+    if (k >= size()) return clear();
+    if (k > size() - k) return rebuild(k);
+    for (; k; k--) {
+        set_.erase(ring_[head_]);
+        ring_[head_] = set_.end();
+        head_ = (head_ + 1) % capacity();
+    }
+}
+
+TEMPLATE
+void SLIDING_WINDOW::clear() {
+    set_.clear();
+    fill(ring_.begin(), ring_.end(), set_.end());
+    head_ = 0;
+}
+
+// The i-th slot after the oldest.
+TEMPLATE
+iterator &SLIDING_WINDOW::slot(size_type i) { return ring_[(head_ + i) % capacity()]; }
+
+// Drops the k oldest keys by rebuilding the set over the others, in O(size()) expected time.
+// One pass over the set in order picks out the keys that stay by their addresses, so they come out sorted, equal ones in arrival order as the multiset keeps them,
+// and the balanced tree is built over them without sorting. Their new iterators then go back to their slots.
+TEMPLATE
+void SLIDING_WINDOW::rebuild(size_type k) {
+    size_type n = size() - k;
+    unordered_map<const T *, size_type> kept;
+    kept.reserve(n);
+    for (size_type i = 0; i < n; i++) kept.emplace(&*slot(k + i), i);
+    vector<T> values;
+    vector<size_type> arrivals;
+    values.reserve(n);
+    arrivals.reserve(n);
+    set_.for_each([&](const T &key) {
+        auto found = kept.find(&key);
+        if (found == kept.end()) return;
+        values.push_back(key);
+        arrivals.push_back(found->second);
+    });
+    
+    set_.clear();
+    set_.insert(make_move_iterator(values.begin()), make_move_iterator(values.end()));
+    vector<Iterator> ring(capacity(), set_.end());
+    Iterator it = set_.begin();
+    for (size_type i: arrivals) ring[i] = it++;
+    ring_ = std::move(ring);
+    head_ = 0;
+}
+
+#undef iterator
+#undef SLIDING_WINDOW
+#undef TEMPLATE
@@ -0,0 +1,69 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+
+#ifndef ORDERED_SET_SLIDING_WINDOW_H
+#define ORDERED_SET_SLIDING_WINDOW_H
+
+#include "ordered_set.h"
+
+// The last capacity keys of a stream, ordered for rank queries: order_of_key counts the keys in the window below a value, find_by_order and quantile pick one by rank.
+// The keys live in an ordered_multiset, and a ring of iterators to them (which stay valid, as nodes never move) remembers their arrival order,
+// so expiring the oldest key erases its node directly, without searching or comparing.
+// Not copyable or movable, as the ring points into the set.
+template<typename T, typename Compare = less<T>, typename Allocator = allocator<T>, typename Policy = tree_policy>
+class sliding_window {
+public:
+    using set_type = ordered_multiset<T, Compare, Allocator, Policy>;
+    using size_type = typename set_type::size_type;
+    using Iterator = typename set_type::Iterator;
+    
+    explicit sliding_window(size_type capacity, const Compare &comp = Compare(), const Allocator &alloc = Allocator());
+    
+    sliding_window(const sliding_window &) = delete;
+    
+    sliding_window &operator=(const sliding_window &) = delete;
+    
+    [[nodiscard]] size_type size() const;
+    
+    [[nodiscard]] size_type capacity() const;
+    
+    [[nodiscard]] bool empty() const;
+    
+    [[nodiscard]] const set_type &keys() const;
+    
+    const T &oldest() const;
+    
+    const T &newest() const;
+    
+    size_type order_of_key(const T &key) const;
+    
+    Iterator find_by_order(size_type k) const;
+    
+    const T &quantile(double q) const;
+    
+    const T &median() const;
+    
+    void push(const T &key);
+    
+    void push(T &&key);
+    
+    void advance(size_type k = 1);
+    
+    void clear();
+
+private:
+    set_type set_;
+    // Iterators to the keys in arrival order, the oldest at head_, wrapping around.
+    vector<Iterator> ring_;
+    size_type head_ = 0;
+    
+    template<typename K>
+    void push_key(K &&key);
+    
+    Iterator &slot(size_type i);
+    
+    void rebuild(size_type k);
+};
+
+#endif //ORDERED_SET_SLIDING_WINDOW_H
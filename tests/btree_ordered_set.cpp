@@ -0,0 +1,65 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Checks btree_ordered_set against std::set under random inserts and erases, for the smallest node size and the default one,
+// and for key types searched by SIMD and by binary search, then walks the leaves in both directions and jumps by iterator arithmetic.
+//
+
+#include "../btree_ordered_set.cpp"
+#include "check.h"
+
+template<typename T, int B>
+void check(int range, mt19937_64 &rng) {
+    btree_ordered_set<T, B> set;
+    std::set<T> reference;
+    // The same keys in an array, for ranks without walking the std::set.
+    vector<T> sorted;
+    auto rank = [&](const T &key) { return std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin(); };
+    for (int step = 0; step < 20000; step++) {
+        auto key = T(rng() % range);
+        int op = int(rng() % 5);
+        if (op <= 1) {
+            auto [it, inserted] = set.insert(key);
+            EXPECT(inserted == reference.insert(key).second && *it == key);
+            if (inserted) sorted.insert(sorted.begin() + rank(key), key);
+            EXPECT(it - set.begin() == rank(key));
+        } else if (op == 2) {
+            bool erased = reference.erase(key);
+            EXPECT(set.erase(key) == erased);
+            if (erased) sorted.erase(sorted.begin() + rank(key));
+        } else {
+            EXPECT(set.order_of_key(key) == size_t(rank(key)));
+            EXPECT(set.upper_bound(key) - set.begin() == std::upper_bound(sorted.begin(), sorted.end(), key) - sorted.begin());
+            EXPECT((set.find(key) == set.end()) == !reference.count(key));
+            if (!set.empty()) {
+                size_t k = rng() % set.size();
+                EXPECT(*set.find_by_order(k) == sorted[k] && set[k] == sorted[k]);
+            }
+        }
+    }
+    EXPECT(set.size() == reference.size());
+    EXPECT(equal(set.begin(), set.end(), reference.begin(), reference.end()));
+    vector<T> backwards;
+    for (auto it = set.end(); it != set.begin();) backwards.push_back(*--it);
+    EXPECT(equal(backwards.begin(), backwards.end(), reference.rbegin(), reference.rend()));
+    for (size_t k = 0; k + 3 <= set.size(); k += 7) {
+        auto it = set.begin() + ptrdiff_t(k);
+        EXPECT(*it == sorted[k] && (it + 3) - it == 3 && (it + 3) - 3 == it);
+    }
+    
+    btree_ordered_set<T, B> built(reference.begin(), reference.end());
+    EXPECT(equal(built.begin(), built.end(), reference.begin(), reference.end()));
+}
+
+int main() {
+    mt19937_64 rng(17);
+    for (int range: {10, 3000, 1000000000}) {
+        check<int, 4>(range, rng);
+        check<long long, 4>(range, rng);
+        check<int, 32>(range, rng);
+        check<long long, 32>(range, rng);
+        check<double, 32>(range, rng);
+        check<unsigned, 6>(range, rng);
+    }
+    return exit_code();
+}
@@ -0,0 +1,64 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Checks buffered_ordered_set against std::set under random writes and reads, for logs of several sizes and with reads rare or frequent,
+// so that queries are answered both from the pending changes and after merging them.
+//
+
+#include "../buffered_ordered_set.cpp"
+#include "check.h"
+
+void check(size_t max_pending, int read_period, mt19937_64 &rng) {
+    buffered_ordered_set<int> set(max_pending);
+    std::set<int> reference;
+    int range = max_pending >= 4096 ? 20000 : 2000;
+    for (int step = 0; step < 50000; step++) {
+        int key = int(rng() % range);
+        if (rng() % read_period >= 2 || rng() % 2) {
+            if (rng() % 8 < 5) {
+                set.insert(key);
+                reference.insert(key);
+            } else {
+                set.erase(key);
+                reference.erase(key);
+            }
+            continue;
+        }
+        auto expected = reference.lower_bound(key);
+        switch (rng() % 4) {
+            case 0:
+                EXPECT(set.order_of_key(key) == size_t(distance(reference.begin(), expected)));
+                break;
+            case 1: {
+                auto found = set.lower_bound(key);
+                EXPECT(found.has_value() == (expected != reference.end()) && (!found || *found == *expected));
+                break;
+            }
+            case 2: {
+                EXPECT(set.size() == reference.size());
+                size_t k = rng() % (reference.size() + 2);
+                auto kth = set.find_by_order(k);
+                EXPECT(kth.has_value() == (k < reference.size()) && (!kth || *kth == *next(reference.begin(), ptrdiff_t(k))));
+                break;
+            }
+            default:
+                EXPECT(set.contains(key) == bool(reference.count(key)));
+        }
+    }
+    EXPECT(set.size() == reference.size());
+    for (size_t k = 0; k < reference.size(); k += 7) EXPECT(*set.find_by_order(k) == *next(reference.begin(), ptrdiff_t(k)));
+    EXPECT(equal(set.keys().begin(), set.keys().end(), reference.begin(), reference.end()));
+}
+
+int main() {
+    mt19937_64 rng(37);
+    for (size_t max_pending: {size_t(1), size_t(3), size_t(16), size_t(100), size_t(4096)}) {
+        for (int read_period: {2, 20, 200}) check(max_pending, read_period, rng);
+    }
+    
+    buffered_ordered_set<string> strings(8);
+    for (int i = 0; i < 1000; i++) strings.insert(to_string(i));
+    strings.erase("5");
+    EXPECT(strings.size() == 999 && !strings.contains("5") && *strings.lower_bound("5") == "50");
+    return exit_code();
+}
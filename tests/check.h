@@ -0,0 +1,20 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// EXPECT(condition) reports a failed condition with its line and carries on, and the test exits with exit_code(), 1 if anything failed.
+//
+
+#ifndef ORDERED_SET_TESTS_CHECK_H
+#define ORDERED_SET_TESTS_CHECK_H
+
+#include <atomic>
+#include <cstdio>
+
+// Atomic, since the concurrent tests check from several threads.
+inline std::atomic<int> failures = 0;
+
+#define EXPECT(condition) ((condition) ? (void) 0 : (void) (fprintf(stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, #condition), failures++))
+
+inline int exit_code() { return failures ? 1 : 0; }
+
+#endif //ORDERED_SET_TESTS_CHECK_H
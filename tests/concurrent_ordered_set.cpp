@@ -0,0 +1,86 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Checks concurrent_ordered_set against std::set from one thread, then has a writer insert 0, 1, 2, ... while readers check that
+// every version they see is a prefix of those keys, so that find_by_order(k) is k and the size never goes down.
+//
+
+#include "../concurrent_ordered_set.cpp"
+#include "check.h"
+#include <atomic>
+#include <thread>
+
+void check_sequential(mt19937_64 &rng) {
+    concurrent_ordered_set<int> set;
+    std::set<int> reference;
+    for (int step = 0; step < 20000; step++) {
+        int key = int(rng() % 3000);
+        int op = int(rng() % 5);
+        if (op <= 1) {
+            EXPECT(set.insert(key) == reference.insert(key).second);
+        } else if (op == 2) {
+            EXPECT(set.erase(key) == bool(reference.erase(key)));
+        } else {
+            auto expected = reference.lower_bound(key);
+            auto found = set.lower_bound(key);
+            EXPECT(found.has_value() == (expected != reference.end()) && (!found || *found == *expected));
+            EXPECT(set.contains(key) == bool(reference.count(key)));
+            EXPECT(set.order_of_key(key) == size_t(distance(reference.begin(), expected)));
+            size_t k = rng() % (reference.size() + 2);
+            auto kth = set.find_by_order(k);
+            EXPECT(kth.has_value() == (k < reference.size()) && (!kth || *kth == *next(reference.begin(), ptrdiff_t(k))));
+        }
+    }
+    set.write([](auto &s) { s.erase(s.begin(), s.lower_bound(1000)); });
+    reference.erase(reference.begin(), reference.lower_bound(1000));
+    EXPECT(set.size() == reference.size());
+    EXPECT(set.read([&](const auto &s) { return equal(s.begin(), s.end(), reference.begin(), reference.end()); }));
+}
+
+void check_concurrent() {
+    const int n = 5000;
+    concurrent_ordered_set<int> set;
+    atomic<bool> done = false;
+    atomic<int> started = 0, reads = 0;
+    vector<thread> readers;
+    for (int t = 0; t < 3; t++) {
+        readers.emplace_back([&, t] {
+            mt19937_64 rng(t);
+            size_t last = 0;
+            started++;
+            while (!done.load()) {
+                set.read([&](const auto &s) {
+                    size_t size = s.size();
+                    EXPECT(size >= last);
+                    last = size;
+                    if (size) {
+                        reads++;
+                        size_t k = rng() % size;
+                        EXPECT(*s.find_by_order(k) == int(k) && s.order_of_key(int(k)) == k);
+                        EXPECT(*prev(s.end()) == int(size) - 1);
+                    }
+                });
+                auto kth = set.find_by_order(last);
+                EXPECT(!kth || *kth == int(last));
+                this_thread::yield();
+            }
+        });
+    }
+    while (started < 3) this_thread::yield();
+    for (int key = 0; key < n; key++) {
+        EXPECT(set.insert(key));
+        // Lets the readers in on a single core too.
+        if (key % 8 == 0) this_thread::yield();
+    }
+    done = true;
+    for (auto &reader: readers) reader.join();
+    EXPECT(reads > 0);
+    EXPECT(set.size() == size_t(n) && !set.insert(n / 2));
+}
+
+int main() {
+    mt19937_64 rng(23);
+    check_sequential(rng);
+    check_concurrent();
+    return exit_code();
+}
@@ -0,0 +1,50 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Checks order_of_keys against order_of_key one key at a time, and the membership it reports against count,
+// for sorted and unsorted batches, on sets and on multisets with many equal elements.
+//
+
+#include "../ordered_set.cpp"
+
+template<typename Set>
+bool check(const char *name, int n, int range, mt19937_64 &rng) {
+    Set set;
+    for (int i = 0; i < n; i++) set.insert(int(rng() % range));
+    vector<int> keys(n);
+    for (int &key: keys) key = int(rng() % (range + 2)) - 1;
+    for (bool sorted: {false, true}) {
+        if (sorted) sort(keys.begin(), keys.end());
+        vector<typename Set::size_type> out(keys.size());
+        set.order_of_keys(keys, out);
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (out[i] != set.order_of_key(keys[i])) {
+                fprintf(stderr, "%s, %d elements in [0, %d), %s batch: order_of_keys gave %zu for %d, order_of_key %zu\n", name, n, range,
+                        sorted ? "sorted" : "unsorted", size_t(out[i]), keys[i], size_t(set.order_of_key(keys[i])));
+                return false;
+            }
+        }
+        auto found = make_unique<bool[]>(keys.size());
+        set.order_of_keys(keys, out, span(found.get(), keys.size()));
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (out[i] != set.order_of_key(keys[i]) || found[i] != bool(set.count(keys[i]))) {
+                fprintf(stderr, "%s, %d elements in [0, %d), %s batch: order_of_keys gave %zu, %d for %d, order_of_key and count %zu, %zu\n", name, n, range,
+                        sorted ? "sorted" : "unsorted", size_t(out[i]), int(found[i]), keys[i], size_t(set.order_of_key(keys[i])), size_t(set.count(keys[i])));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main() {
+    mt19937_64 rng(42);
+    bool ok = true;
+    for (int n: {0, 1, 7, 100, 10000}) {
+        for (int range: {1, 3, 100, 1000000}) {
+            ok &= check<ordered_set<int>>("ordered_set", n, range, rng);
+            ok &= check<ordered_multiset<int>>("ordered_multiset", n, range, rng);
+        }
+    }
+    return ok ? 0 : 1;
+}
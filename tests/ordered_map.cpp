@@ -0,0 +1,79 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Checks ordered_map against std::map under random operator[], try_emplace, insert_or_assign, at and erase, with both ways of rebalancing,
+// then find_by_order, order_of_key and split on the result.
+//
+
+#include "../ordered_map.cpp"
+#include "check.h"
+
+struct single_pass_policy : tree_policy {
+    using rebalancing = single_pass_rebalancing;
+};
+
+template<typename Map>
+void check(int range, mt19937_64 &rng) {
+    Map map;
+    std::map<int, string> reference;
+    for (int step = 0; step < 20000; step++) {
+        int key = int(rng() % range);
+        string value = to_string(step);
+        switch (rng() % 6) {
+            case 0:
+                map[key] += value;
+                reference[key] += value;
+                break;
+            case 1: {
+                auto [it, inserted] = map.try_emplace(key, value);
+                auto [expected, expected_inserted] = reference.try_emplace(key, value);
+                EXPECT(inserted == expected_inserted && it->first == key && it->second == expected->second);
+                break;
+            }
+            case 2: {
+                auto [it, inserted] = map.insert_or_assign(key, value);
+                EXPECT(inserted == reference.insert_or_assign(key, value).second && it->second == value);
+                break;
+            }
+            case 3:
+                EXPECT(map.erase(key) == bool(reference.erase(key)));
+                break;
+            case 4:
+                if (reference.count(key)) EXPECT(map.at(key) == reference.at(key));
+                else EXPECT(!map.contains(key));
+                break;
+            default:
+                EXPECT(map.order_of_key(key) == size_t(distance(reference.begin(), reference.lower_bound(key))));
+        }
+    }
+    map.validate();
+    EXPECT(map.size() == reference.size());
+    auto expected = reference.begin();
+    for (size_t k = 0; k < map.size(); k++, ++expected) {
+        auto it = map.find_by_order(k);
+        EXPECT(it->first == expected->first && it->second == expected->second);
+    }
+    
+    int middle = range / 2;
+    Map upper = map.split(middle);
+    EXPECT(map.size() == size_t(distance(reference.begin(), reference.lower_bound(middle))));
+    EXPECT(map.size() + upper.size() == reference.size());
+    EXPECT(upper.empty() || upper.find_by_order(0)->first == reference.lower_bound(middle)->first);
+}
+
+int main() {
+    mt19937_64 rng(11);
+    for (int range: {3, 500, 1000000}) {
+        check<ordered_map<int, string>>(range, rng);
+        check<ordered_map<int, string, less<int>, allocator<map_entry<int, string>>, single_pass_policy>>(range, rng);
+    }
+    ordered_map<int, string> empty;
+    bool threw = false;
+    try {
+        empty.at(1);
+    } catch (const out_of_range &) {
+        threw = true;
+    }
+    EXPECT(threw);
+    return exit_code();
+}
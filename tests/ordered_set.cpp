@@ -0,0 +1,96 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Checks ordered_set and ordered_multiset against std::set and std::multiset under random inserts, hinted inserts and erases by key, iterator and range,
+// for both layouts and both ways of rebalancing, comparing every query and validating the tree as it goes.
+// Elements carry an id besides the key, so that a multiset is also checked to keep equal keys in insertion order.
+//
+
+#include "../ordered_set.cpp"
+#include "check.h"
+
+struct Entry {
+    int key, id;
+    
+    bool operator==(const Entry &other) const { return key == other.key && id == other.id; }
+};
+
+struct by_key {
+    bool operator()(const Entry &a, const Entry &b) const { return a.key < b.key; }
+};
+
+struct compact_policy : tree_policy {
+    using layout = compact_layout;
+};
+
+struct single_pass_policy : tree_policy {
+    using rebalancing = single_pass_rebalancing;
+};
+
+template<typename Set, typename Reference>
+void check(int range, mt19937_64 &rng) {
+    Set set;
+    Reference reference;
+    auto reference_at = [&](size_t k) { return next(reference.begin(), ptrdiff_t(k)); };
+    for (int step = 0; step < 20000; step++) {
+        Entry entry{int(rng() % range), step};
+        int op = int(rng() % 8);
+        if (op <= 2) {
+            auto [it, inserted] = set.insert(entry);
+            size_t before = reference.size();
+            reference.insert(entry);
+            bool expected = reference.size() > before;
+            EXPECT(inserted == expected && it->key == entry.key);
+        } else if (op == 3) {
+            // A hint at a random position, right where the key belongs or not.
+            size_t k = rng() % (set.size() + 1);
+            auto it = set.insert(set.find_by_order(k), entry);
+            reference.insert(entry);
+            EXPECT(it->key == entry.key);
+        } else if (op == 4) {
+            auto found = reference.lower_bound(entry);
+            bool expected = found != reference.end() && found->key == entry.key;
+            if (expected) reference.erase(found);
+            EXPECT(set.erase(entry) == expected);
+        } else if (op == 5 && !set.empty()) {
+            size_t k = rng() % set.size();
+            auto it = set.erase(set.find_by_order(k));
+            EXPECT(it - set.begin() == ptrdiff_t(k));
+            reference.erase(reference_at(k));
+        } else if (op == 6 && !set.empty()) {
+            size_t first = rng() % set.size(), last = first + rng() % min<size_t>(40, set.size() - first + 1);
+            set.erase(set.find_by_order(first), set.find_by_order(last));
+            reference.erase(reference_at(first), reference_at(last));
+        } else {
+            EXPECT(set.order_of_key(entry) == size_t(distance(reference.begin(), reference.lower_bound(entry))));
+            EXPECT(set.upper_bound(entry) - set.begin() == distance(reference.begin(), reference.upper_bound(entry)));
+            EXPECT(set.count(entry) == reference.count(entry));
+            auto it = set.find(entry);
+            EXPECT((it == set.end()) == !reference.count(entry));
+            if (!set.empty()) {
+                size_t k = rng() % set.size();
+                EXPECT(*set.find_by_order(k) == *reference_at(k));
+            }
+        }
+        if (step % 2000 == 0) set.validate();
+    }
+    set.validate();
+    EXPECT(set.size() == reference.size());
+    EXPECT(equal(set.begin(), set.end(), reference.begin(), reference.end()));
+    vector<Entry> backwards;
+    for (auto it = set.end(); it != set.begin();) backwards.push_back(*--it);
+    EXPECT(equal(backwards.begin(), backwards.end(), reference.rbegin(), reference.rend()));
+}
+
+int main() {
+    mt19937_64 rng(7);
+    for (int range: {5, 300, 1000000}) {
+        check<ordered_set<Entry, by_key>, set<Entry, by_key>>(range, rng);
+        check<ordered_set<Entry, by_key, allocator<Entry>, compact_policy>, set<Entry, by_key>>(range, rng);
+        check<ordered_set<Entry, by_key, allocator<Entry>, single_pass_policy>, set<Entry, by_key>>(range, rng);
+        check<ordered_multiset<Entry, by_key>, multiset<Entry, by_key>>(range, rng);
+        check<ordered_multiset<Entry, by_key, allocator<Entry>, compact_policy>, multiset<Entry, by_key>>(range, rng);
+        check<ordered_multiset<Entry, by_key, allocator<Entry>, single_pass_policy>, multiset<Entry, by_key>>(range, rng);
+    }
+    return exit_code();
+}
@@ -0,0 +1,60 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Checks persistent_ordered_set against std::set under random inserts and erases, keeping a snapshot every so often,
+// then checks that every snapshot still holds what the std::set held when it was taken, scanning it both ways and jumping by iterator arithmetic.
+//
+
+#include "../persistent_ordered_set.cpp"
+#include "check.h"
+
+void check_version(const persistent_ordered_set<int> &set, const std::set<int> &reference) {
+    EXPECT(set.size() == reference.size());
+    EXPECT(equal(set.begin(), set.end(), reference.begin(), reference.end()));
+    vector<int> backwards;
+    for (auto it = set.end(); it != set.begin();) backwards.push_back(*--it);
+    EXPECT(equal(backwards.begin(), backwards.end(), reference.rbegin(), reference.rend()));
+    auto expected = reference.begin();
+    for (size_t k = 0; k < set.size(); k += 5, advance(expected, min<ptrdiff_t>(5, distance(expected, reference.end())))) {
+        EXPECT(*(set.begin() + ptrdiff_t(k)) == *expected && set[k] == *expected);
+        EXPECT((set.end() - ptrdiff_t(set.size() - k)) - set.begin() == ptrdiff_t(k));
+    }
+}
+
+void check(int range, mt19937_64 &rng) {
+    persistent_ordered_set<int> set;
+    std::set<int> reference;
+    vector<pair<persistent_ordered_set<int>, std::set<int>>> versions;
+    for (int step = 0; step < 20000; step++) {
+        int key = int(rng() % range);
+        int op = int(rng() % 5);
+        if (op <= 1) {
+            EXPECT(set.insert(key) == reference.insert(key).second);
+        } else if (op == 2) {
+            EXPECT(set.erase(key) == bool(reference.erase(key)));
+        } else {
+            EXPECT(set.order_of_key(key) == size_t(distance(reference.begin(), reference.lower_bound(key))));
+            EXPECT(set.upper_bound(key) - set.begin() == distance(reference.begin(), reference.upper_bound(key)));
+            EXPECT((set.find(key) == set.end()) == !reference.count(key));
+        }
+        if (step % 1000 == 0) versions.emplace_back(set, reference);
+    }
+    check_version(set, reference);
+    for (const auto &[version, expected]: versions) check_version(version, expected);
+    
+    persistent_ordered_set<int> built(reference.begin(), reference.end());
+    check_version(built, reference);
+    bool threw = false;
+    try {
+        *set.end();
+    } catch (const out_of_range &) {
+        threw = true;
+    }
+    EXPECT(threw);
+}
+
+int main() {
+    mt19937_64 rng(19);
+    for (int range: {10, 3000, 1000000000}) check(range, rng);
+    return exit_code();
+}
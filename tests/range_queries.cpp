@@ -0,0 +1,60 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Checks count_in_range, kth_at_or_after and quantile_in_range against the order_of_key and find_by_order calls they fuse, on sets and multisets.
+// k covers 0, both sides of the point where kth_at_or_after stops climbing (256), size() and orders near the largest size_type.
+//
+
+#include "../ordered_set.cpp"
+
+template<typename Set>
+bool check(const char *name, int n, int range, mt19937_64 &rng) {
+    using size_type = typename Set::size_type;
+    Set set;
+    for (int i = 0; i < n; i++) set.insert(int(rng() % range));
+    auto fail = [&](const char *query, int lo, int hi, size_t arg) {
+        fprintf(stderr, "%s, %d elements in [0, %d): %s wrong for [%d, %d), %zu\n", name, n, range, query, lo, hi, arg);
+        return false;
+    };
+    
+    constexpr size_type MAX = numeric_limits<size_type>::max();
+    for (int i = 0; i < 200; i++) {
+        int lo = int(rng() % (range + 2)) - 1, hi = int(rng() % (range + 2)) - 1;
+        size_type before = set.order_of_key(lo), count = lo < hi ? set.order_of_key(hi) - before : 0;
+        if (set.count_in_range(lo, hi) != count) return fail("count_in_range", lo, hi, 0);
+        
+        for (size_type k: {size_type(0), size_type(1), size_type(rng() % 300), size_type(255), size_type(256), size_type(257), set.size() - before,
+                           set.size(), set.size() + 1, MAX - 3, MAX}) {
+            auto expected = k < set.size() - before ? set.find_by_order(before + k) : set.end();
+            if (set.kth_at_or_after(lo, k) != expected) return fail("kth_at_or_after", lo, lo, k);
+        }
+        
+        for (double q: {0.0, 0.25, 0.5, double(rng() % 1001) / 1000, 1.0}) {
+            auto rank = size_type(ceil(q * double(count)));
+            auto expected = count ? set.find_by_order(before + (rank ? min(rank, count) - 1 : 0)) : set.end();
+            if (set.quantile_in_range(lo, hi, q) != expected) return fail("quantile_in_range", lo, hi, size_t(q * 1000));
+        }
+    }
+    return true;
+}
+
+int main() {
+    mt19937_64 rng(42);
+    bool ok = true;
+    for (int n: {0, 1, 7, 100, 10000}) {
+        for (int range: {1, 3, 100, 1000000}) {
+            ok &= check<ordered_set<int>>("ordered_set", n, range, rng);
+            ok &= check<ordered_multiset<int>>("ordered_multiset", n, range, rng);
+        }
+    }
+    
+    // The case that once wrapped around: rank + k overflowed and landed back inside the set.
+    ordered_set<int> evens;
+    for (int i = 0; i < 2000; i += 2) evens.insert(i);
+    auto max = numeric_limits<ordered_set<int>::size_type>::max();
+    if (evens.kth_at_or_after(10, max) != evens.end() || evens.kth_at_or_after(10, max - 3) != evens.end()) {
+        fprintf(stderr, "kth_at_or_after wrapped around for k near the largest size_type\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Saves sets of random keys, then checks that load gives back the same set and that mapped_ordered_set answers queries like std::set on them,
+// and that a corrupted or truncated file is rejected.
+//
+
+#include "../ordered_set.cpp"
+#include "../mapped_ordered_set.cpp"
+#include "check.h"
+#include <filesystem>
+
+template<typename F>
+bool throws(F f) {
+    try {
+        f();
+    } catch (const runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+void check(const string &path, size_t n, long long range, mt19937_64 &rng) {
+    ordered_set<long long> set;
+    std::set<long long> reference;
+    for (size_t i = 0; i < n; i++) {
+        long long key = (long long) (rng() % range) - range / 2;
+        set.insert(key);
+        reference.insert(key);
+    }
+    set.save(path);
+    
+    ordered_set<long long> loaded;
+    loaded.insert(1);
+    loaded.load(path);
+    loaded.validate();
+    EXPECT(loaded.size() == reference.size() && equal(loaded.begin(), loaded.end(), reference.begin(), reference.end()));
+    
+    mapped_ordered_set<long long> mapped(path);
+    EXPECT(mapped.verify());
+    EXPECT(mapped.size() == reference.size() && equal(mapped.begin(), mapped.end(), reference.begin(), reference.end()));
+    vector<long long> sorted(reference.begin(), reference.end());
+    for (int q = 0; q < 2000; q++) {
+        long long key = (long long) (rng() % range) - range / 2;
+        auto expected = std::lower_bound(sorted.begin(), sorted.end(), key);
+        size_t order = expected - sorted.begin();
+        EXPECT(mapped.lower_bound(key) - mapped.begin() == ptrdiff_t(order));
+        EXPECT(mapped.upper_bound(key) - mapped.begin() == std::upper_bound(sorted.begin(), sorted.end(), key) - sorted.begin());
+        EXPECT((mapped.find(key) != mapped.end()) == bool(reference.count(key)));
+        EXPECT(mapped.order_of_key(key) == order);
+        EXPECT(mapped.find_by_order(order) == mapped.begin() + ptrdiff_t(order));
+        EXPECT(order == sorted.size() || mapped[order] == *expected);
+    }
+}
+
+// Flips a byte of the last element and then cuts the last element off, checking that both load and mapped_ordered_set notice.
+void check_damaged(const string &path) {
+    ordered_set<long long> set;
+    for (long long key = 0; key < 1000; key++) set.insert(key * key);
+    set.save(path);
+    auto bytes = filesystem::file_size(path);
+    {
+        fstream file(path, ios::binary | ios::in | ios::out);
+        file.seekp(streamoff(bytes - 1));
+        file.put(char(0x5a));
+    }
+    ordered_set<long long> loaded;
+    EXPECT(throws([&] { loaded.load(path); }) && loaded.empty());
+    EXPECT(!mapped_ordered_set<long long>(path).verify());
+    
+    filesystem::resize_file(path, bytes - sizeof(long long));
+    EXPECT(throws([&] { loaded.load(path); }) && loaded.empty());
+    EXPECT(throws([&] { mapped_ordered_set<long long> mapped(path); }));
+    
+    filesystem::resize_file(path, 3);
+    EXPECT(throws([&] { loaded.load(path); }) && loaded.empty());
+    EXPECT(throws([&] { mapped_ordered_set<long long> mapped(path); }));
+    filesystem::remove(path);
+    EXPECT(throws([&] { loaded.load(path); }));
+    EXPECT(throws([&] { mapped_ordered_set<long long> mapped(path); }));
+}
+
+int main() {
+    mt19937_64 rng(29);
+    string path = (filesystem::temp_directory_path() / ("ordered_set_save_load_test_" + to_string(rng()))).string();
+    for (size_t n: {0, 1, 100, 100000}) for (long long range: {10LL, 1000000000000LL}) check(path, n, range, rng);
+    check_damaged(path);
+    filesystem::remove(path);
+    return exit_code();
+}
@@ -0,0 +1,93 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Checks split, join, unite, intersect and subtract, their parallel versions, and bulk and parallel inserts against the std:: algorithms on sorted vectors,
+// for operands on their own node pools and on one shared by a split, validating every result.
+//
+
+#include "../ordered_set.cpp"
+#include "check.h"
+
+using Set = ordered_set<int>;
+
+vector<int> random_keys(size_t n, int range, mt19937_64 &rng) {
+    vector<int> keys(n);
+    for (int &key: keys) key = int(rng() % range);
+    return keys;
+}
+
+vector<int> sorted_unique(vector<int> keys) {
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+bool same(const Set &set, const vector<int> &expected) {
+    set.validate();
+    return set.size() == expected.size() && equal(set.begin(), set.end(), expected.begin(), expected.end());
+}
+
+void check_operations(size_t n, int range, mt19937_64 &rng) {
+    vector<int> a = sorted_unique(random_keys(n, range, rng)), b = sorted_unique(random_keys(n / 2 + 1, range, rng));
+    vector<int> expected;
+    auto run = [&](auto operation, auto algorithm) {
+        for (bool shared: {false, true}) {
+            // An empty split-off part shares left's pool, so right's nodes are allocated among left's.
+            Set left(a.begin(), a.end());
+            Set right = shared ? left.split_by_order(left.size()) : Set();
+            right.insert(b.begin(), b.end());
+            operation(left, std::move(right));
+            expected.clear();
+            algorithm(a.begin(), a.end(), b.begin(), b.end(), back_inserter(expected));
+            EXPECT(same(left, expected));
+        }
+    };
+    auto set_union = [](auto... args) { return std::set_union(args...); };
+    auto set_intersection = [](auto... args) { return std::set_intersection(args...); };
+    auto set_difference = [](auto... args) { return std::set_difference(args...); };
+    run([](Set &left, Set &&right) { left.unite(std::move(right)); }, set_union);
+    run([](Set &left, Set &&right) { left.intersect(std::move(right)); }, set_intersection);
+    run([](Set &left, Set &&right) { left.subtract(std::move(right)); }, set_difference);
+    run([](Set &left, Set &&right) { left.parallel_unite(std::move(right), 4); }, set_union);
+    run([](Set &left, Set &&right) { left.parallel_intersect(std::move(right), 4); }, set_intersection);
+    
+    // split and join put the set back together, splitting anywhere.
+    Set set(a.begin(), a.end());
+    int key = int(rng() % range);
+    Set upper = set.split(key);
+    auto middle = std::lower_bound(a.begin(), a.end(), key);
+    EXPECT(same(set, vector<int>(a.begin(), middle)) && same(upper, vector<int>(middle, a.end())));
+    set.join(std::move(upper));
+    EXPECT(same(set, a) && upper.empty());
+    size_t k = rng() % (a.size() + 1);
+    upper = set.split_by_order(k);
+    EXPECT(set.size() == k && same(upper, vector<int>(a.begin() + ptrdiff_t(k), a.end())));
+}
+
+void check_inserts(size_t n, int range, mt19937_64 &rng) {
+    vector<int> initial = random_keys(n, range, rng), batch = random_keys(n, range, rng);
+    vector<int> all = initial;
+    all.insert(all.end(), batch.begin(), batch.end());
+    all = sorted_unique(all);
+    
+    Set bulk(initial.begin(), initial.end()), parallel(initial.begin(), initial.end());
+    bulk.insert(batch.begin(), batch.end());
+    parallel.parallel_insert(batch.begin(), batch.end(), 4);
+    EXPECT(same(bulk, all) && same(parallel, all));
+    
+    // The chunks are visited concurrently, so only the sum can be compared.
+    atomic<long long> sum = 0;
+    parallel.parallel_for_each(parallel.begin(), parallel.end(), [&](int key) { sum += key; }, 4);
+    EXPECT(sum == accumulate(all.begin(), all.end(), 0LL));
+}
+
+int main() {
+    mt19937_64 rng(13);
+    for (size_t n: {0, 1, 100, 5000, 200000}) {
+        for (int range: {50, 1000000000}) {
+            check_operations(n, range, rng);
+            check_inserts(n, range, rng);
+        }
+    }
+    return exit_code();
+}
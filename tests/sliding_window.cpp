@@ -0,0 +1,65 @@
+//
+// Created by Eddard on 2023-03-05.
+//
+// Checks sliding_window against a std::deque of the keys in arrival order and a std::multiset of the same keys, under random pushes and advances.
+//
+
+#include "../sliding_window.cpp"
+#include "check.h"
+#include <deque>
+
+void check(size_t capacity, int range, mt19937_64 &rng) {
+    sliding_window<int> window(capacity);
+    deque<int> arrivals;
+    multiset<int> reference;
+    for (int step = 0; step < 20000; step++) {
+        int key = int(rng() % range);
+        int op = int(rng() % 20);
+        if (op < 12) {
+            window.push(key);
+            if (arrivals.size() == capacity) {
+                reference.erase(reference.find(arrivals.front()));
+                arrivals.pop_front();
+            }
+            arrivals.push_back(key);
+            reference.insert(key);
+        } else if (op == 12) {
+            size_t k = rng() % (capacity + 2);
+            if (rng() % 50 == 0) k = capacity;
+            window.advance(k);
+            for (; k && !arrivals.empty(); k--) {
+                reference.erase(reference.find(arrivals.front()));
+                arrivals.pop_front();
+            }
+        } else if (op == 13 && rng() % 20 == 0) {
+            window.clear();
+            arrivals.clear();
+            reference.clear();
+        } else {
+            EXPECT(window.size() == arrivals.size());
+            EXPECT(window.order_of_key(key) == size_t(distance(reference.begin(), reference.lower_bound(key))));
+            if (arrivals.empty()) continue;
+            EXPECT(window.oldest() == arrivals.front() && window.newest() == arrivals.back());
+            size_t k = rng() % reference.size();
+            EXPECT(*window.find_by_order(k) == *next(reference.begin(), ptrdiff_t(k)));
+            double q = rng() % 4 ? double(rng() % 1001) / 1000 : double(rng() % 2);
+            auto rank = size_t(ceil(q * double(reference.size())));
+            EXPECT(window.quantile(q) == *next(reference.begin(), ptrdiff_t(rank ? rank - 1 : 0)));
+            EXPECT(window.median() == *next(reference.begin(), ptrdiff_t((reference.size() - 1) / 2)));
+        }
+    }
+    EXPECT(equal(window.keys().begin(), window.keys().end(), reference.begin(), reference.end()));
+}
+
+int main() {
+    mt19937_64 rng(31);
+    for (size_t capacity: {1, 2, 17, 1000}) for (int range: {5, 1000000}) check(capacity, range, rng);
+    bool threw = false;
+    try {
+        sliding_window<int> window(0);
+    } catch (const invalid_argument &) {
+        threw = true;
+    }
+    EXPECT(threw);
+    return exit_code();
+}